@@ -0,0 +1,202 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+// Headless PhysicsBus benchmark, no SDL or Vulkan involved so it runs on gpu-less boxes.
+// Usage: 2g43s_physics_bench [--scene volume|square|all] [--bodies N] [--ticks N] [--threads 0,1,3,7] [--worlds N]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PhysicsBus.hpp"
+
+struct BenchOptions {
+    std::string scene = "all";
+    uint32_t bodies = 1024;
+    uint32_t ticks = 1024;
+    uint32_t worlds = 1; // Independent copies of the scene, stepped concurrently
+    std::vector<int> threads{};
+};
+
+struct BenchResult {
+    int threads = 0;
+    double p50 = 0, p90 = 0, p99 = 0, max = 0, mean = 0; // ms
+    double activeBodies = 0;
+    double collisionSteps = 0;
+    double captureUs = 0; // Snapshot capture per tick, summed over worlds
+    double realtimeFactor = 0;
+};
+
+static std::vector<int> parseThreads(const char* list) {
+    std::vector<int> threads{};
+    for (const char* it = list; *it != '\0';) {
+        threads.emplace_back(std::atoi(it));
+        while (*it != '\0' && *it != ',') it++;
+        if (*it == ',') it++;
+    }
+    return threads;
+}
+
+static BenchOptions parseOptions(const int argc, char** argv) {
+    BenchOptions options{};
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--scene")) options.scene = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--bodies")) options.bodies = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--ticks")) options.ticks = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--threads")) options.threads = parseThreads(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--worlds")) options.worlds = std::max(1, std::atoi(argv[i + 1]));
+        else std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+    }
+
+    // Powers of two up to every core
+    if (options.threads.empty()) {
+        const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for (int workers = 0; workers < cores; workers = workers ? workers * 2 : 1) {
+            options.threads.emplace_back(workers);
+        }
+        if (options.threads.back() != cores - 1) options.threads.emplace_back(cores - 1);
+    }
+
+    return options;
+}
+
+#pragma region Scenes
+static JPH::BodyCreationSettings boxSettings(const JPH::RVec3 pos) {
+    JPH::BodyCreationSettings settings(new JPH::BoxShape(JPH::Vec3(0.5f, 0.5f, 0.5f)), pos, JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Layers::MOVING);
+    settings.mOverrideMassProperties = JPH::EOverrideMassProperties::CalculateInertia;
+    settings.mMassPropertiesOverride.mMass = 32;
+    settings.mLinearDamping = 0.05f;
+    settings.mAngularDamping = 0.05f;
+    return settings;
+}
+
+static void ground(const PhysicsBus& bus, const uint32_t world, const float halfExtent) {
+    const JPH::BodyCreationSettings settings(new JPH::BoxShape(JPH::Vec3(halfExtent, halfExtent, 1.0f)), JPH::RVec3(0, 0, -5), JPH::Quat::sIdentity(), JPH::EMotionType::Static, Layers::NON_MOVING);
+    bus.createBody(settings, world);
+}
+
+// Random boxes in a volume scaled to the body count, like ModelEntityManager::randomVolume but with its own bounds. Seeded so runs are comparable
+static void randomVolume(const PhysicsBus& bus, const uint32_t world, const uint32_t count) {
+    std::mt19937 engine(43);
+    const float extent = std::cbrt(static_cast<float>(count)) * 2.0f;
+    std::uniform_real_distribution xy(-extent, extent);
+    std::uniform_real_distribution z(0.0f, extent * 2.0f);
+
+    ground(bus, world, extent * 2.0f);
+    for (uint32_t i = 0; i < count; ++i) {
+        bus.createBody(boxSettings(JPH::RVec3(xy(engine), xy(engine), z(engine))), world);
+    }
+}
+
+// The bench's own grid: count bodies centred on the origin, 1.5 apart. Not ModelEntityManager::square, which places count * count
+static void square(const PhysicsBus& bus, const uint32_t world, const uint32_t count) {
+    const auto side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    constexpr float gap = 1.5f;
+
+    ground(bus, world, side * gap);
+    for (uint32_t x = 0; x < side; ++x) {
+        for (uint32_t y = 0; y < side && x * side + y < count; ++y) {
+            bus.createBody(boxSettings(JPH::RVec3(x * gap - side * gap * 0.5f, y * gap - side * gap * 0.5f, 0)), world);
+        }
+    }
+}
+#pragma endregion
+
+static double percentile(const std::vector<double>& sorted, const double p) {
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())))];
+}
+
+static BenchResult run(const std::string& scene, const BenchOptions& options, const int threads) {
+    PhysicsBus bus{};
+    bus.THREADS = threads;
+    bus.MAX_BARRIERS = std::max(bus.MAX_BARRIERS, options.worlds * 2);
+    bus.DEFAULT_WORLD.maxBodies = options.bodies + 16;
+    bus.DEFAULT_WORLD.maxBodyPairs = options.bodies * 8;
+    bus.DEFAULT_WORLD.maxContactConstraints = options.bodies * 8;
+    bus.initializeJPH();
+
+    for (uint32_t world = 1; world < options.worlds; ++world) {
+        bus.addWorld(bus.DEFAULT_WORLD);
+    }
+
+    for (uint32_t world = 0; world < options.worlds; ++world) {
+        if (scene == "square") square(bus, world, options.bodies);
+        else randomVolume(bus, world, options.bodies);
+
+        bus.world(world).physics_system->OptimizeBroadPhase();
+    }
+
+    std::vector<double> times(options.ticks);
+    double activeSum = 0;
+    double stepsSum = 0;
+    double captureSum = 0;
+
+    // One tick worth of wall time per call, so every call steps exactly once with adaptive collision steps
+    for (uint32_t tick = 0; tick < options.ticks; ++tick) {
+        const auto start = std::chrono::steady_clock::now();
+        bus.advance(bus.cDeltaTime);
+        const auto end = std::chrono::steady_clock::now();
+
+        times[tick] = std::chrono::duration<double, std::milli>(end - start).count();
+        activeSum += static_cast<double>(bus.getAwakeBodyCount());
+        for (const auto& world : bus.worlds) {
+            stepsSum += static_cast<double>(world.collisionSteps) / options.worlds;
+            captureSum += world.history.stats.lastCaptureUs;
+        }
+    }
+
+    bus.shutdownJPH();
+
+    BenchResult result{};
+    result.threads = threads;
+    result.mean = std::accumulate(times.begin(), times.end(), 0.0) / options.ticks;
+    result.activeBodies = activeSum / options.ticks;
+    result.collisionSteps = stepsSum / options.ticks;
+    result.captureUs = captureSum / options.ticks;
+    result.realtimeFactor = bus.cDeltaTime * 1000.0 / result.mean;
+
+    std::ranges::sort(times);
+    result.p50 = percentile(times, 0.50);
+    result.p90 = percentile(times, 0.90);
+    result.p99 = percentile(times, 0.99);
+    result.max = times.back();
+
+    return result;
+}
+
+int main(int argc, char** argv) {
+    const BenchOptions options = parseOptions(argc, argv);
+    Logger LOGGER{"PhysicsBench"};
+
+    std::vector<std::string> scenes{};
+    if (options.scene == "all") scenes = {"volume", "square"};
+    else scenes = {options.scene};
+
+    for (const auto& scene : scenes) {
+        LOGGER.info("Scene ${}, ${} bodies in ${} worlds, ${} ticks at ${} Hz", scene, options.bodies, options.worlds, options.ticks, PhysicsBus{}.TICK_RATE);
+        LOGGER.info("Snapshots ${} bytes per awake body", PhysicsHistory::BYTES_PER_BODY);
+        std::printf("%8s %9s %9s %9s %9s %9s %10s %6s %9s %9s %9s\n", "workers", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms", "active", "steps", "snap us", "realtime", "scaling");
+
+        double baseline = 0;
+        for (const int threads : options.threads) {
+            const BenchResult result = run(scene, options, threads);
+            if (baseline == 0) baseline = result.mean;
+
+            std::printf("%8d %9.3f %9.3f %9.3f %9.3f %9.3f %10.1f %6.2f %9.1f %8.2fx %8.2fx\n",
+                result.threads, result.mean, result.p50, result.p90, result.p99, result.max,
+                result.activeBodies, result.collisionSteps, result.captureUs, result.realtimeFactor, baseline / result.mean);
+        }
+    }
+
+    return 0;
+}
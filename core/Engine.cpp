@@ -22,11 +22,7 @@
 void Engine::initialize(SDL_Window* sdl_window) {
     const auto start = std::chrono::high_resolution_clock::now();
 
-    const std::vector<std::filesystem::path> dirtyShaders = Shaders::getShadersToCompile();
-    for (auto& dirtyShader : dirtyShaders) {
-        auto shader = Shaders::compileShader(dirtyShader);
-        Shaders::saveShaderToFile(Tools::getShaderPath() + "compiled/" + dirtyShader.lexically_relative(Tools::getShaderPath()).replace_extension(".spv").string(), shader);
-    }
+    Shaders::compileShaders();
 
     this->window = sdl_window;
 
@@ -37,6 +33,10 @@ void Engine::initialize(SDL_Window* sdl_window) {
     initializeCore();
     initializeVulkan();
 
+    const GpuAllocator::Stats memory = GpuAllocator::stats();
+    logger.info("GPU memory: ${} allocations in ${} blocks + ${} dedicated, ${} MB used, fragmentation ${}",
+        memory.allocations, memory.blocks, memory.dedicated, (memory.usedBytes + memory.dedicatedBytes) / (1024 * 1024), memory.fragmentation());
+
     const auto end = std::chrono::high_resolution_clock::now();
     const std::chrono::duration<double> duration = end - start;
 
@@ -45,8 +45,27 @@ void Engine::initialize(SDL_Window* sdl_window) {
     initialized = true;
 }
 
+void Engine::initializeHeadless() {
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    sid = Random::randomNum<uint64_t>(1000000000,9999999999);
+    logger = Logger("engine.hpp");
+
+    headless = true;
+    modelEntityManager.collisionOnly = true;
+    modelEntityManager.scene();
+
+    const auto end = std::chrono::high_resolution_clock::now();
+    const std::chrono::duration<double> duration = end - start;
+
+    logger.success("2g43s engine STARTED headless in ${} seconds!", duration.count());
+    initialized = true;
+}
+
 // Clean trash before closing app
 void Engine::cleanup() const {
+    if (headless) return;
+
     vkDeviceWaitIdle(device);
 
     swapchainManager.cleanupSwapchain();
@@ -60,14 +79,7 @@ void Engine::cleanup() const {
 
     graphicsManager.cleanup();
 
-    for (size_t i = 0; i < framesInFlight; i++) {
-        vkDestroyBuffer(device, bufferManager.drawCommandsBuffers[i], nullptr);
-        vkFreeMemory(device, bufferManager.drawCommandsBuffersMemory[i], nullptr);
-
-        vkDestroyBuffer(device, bufferManager.drawCommandsSourceBuffers[i], nullptr);
-        vkFreeMemory(device, bufferManager.drawCommandsSourceBuffersMemory[i], nullptr);
-    }
-
+    GpuAllocator::cleanup(device);
     vkDestroyDevice(device, nullptr);
 
     if constexpr (enableValidationLayers) {
@@ -1,6 +1,8 @@
 #ifndef ENGINE_HPP
 #define ENGINE_HPP
 
+#include <atomic>
+
 #include <SDL3/SDL_video.h>
 #include <vulkan/vulkan_core.h>
 
@@ -28,6 +30,9 @@ public:
     #pragma region Main
     void initialize(SDL_Window* sdl_window);
 
+    // Scene and physics only, no window, Vulkan or gpu buffers
+    void initializeHeadless();
+
     // Clean trash before closing app
     void cleanup() const;
     #pragma endregion
@@ -53,9 +58,10 @@ public:
     // Other stuff
 
     bool depth = false;
-    bool initialized = false;
+    bool headless = false;
+    std::atomic<bool> initialized = false; // Read by the tick thread
     bool framebufferResized = false;
-    bool quit = false;
+    std::atomic<bool> quit = false;
 
     glm::vec2 mousePosition{};
     glm::vec2 mousePointerPosition{};
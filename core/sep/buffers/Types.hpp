@@ -27,25 +27,6 @@ struct VisibleIndicesBuffer {
 
 
 
-struct alignas(16) Index {
-    uint32_t firstIndex;
-    uint32_t indexCount;
-    uint32_t globalVertexOffset;
-    uint32_t pad2;
-};
-
-struct TextureIndexBuffer {
-    std::vector<Index> indices;
-};
-
-
-
-struct TextureIndexOffsetBuffer {
-    std::vector<uint32_t> indexOffsets;
-};
-
-
-
 struct UniformBuffer {
     glm::mat4 view;
     glm::mat4 proj;
@@ -56,7 +37,18 @@ struct UniformBuffer {
 
 struct UniformCullingBuffer {
     glm::vec4 planes[6];
+    glm::mat4 viewProjection;
+    glm::uvec4 pyramidLevels[16]; // DepthPyramid::Level
     uint32_t totalObjects;
+    uint32_t pyramidLevelCount;
+    uint32_t depthWidth;
+    uint32_t depthHeight;
+
+    // A sphere at view depth w covers radius * pixelScale / w pixels
+    float pixelScale;
+    float minPixelRadius; // Smaller spheres aren't drawn at all
+    float impostorDistance; // Farther spheres are drawn as impostors, 0 turns them off
+    uint32_t impostorRows; // Draw commands with a baked atlas row
 };
 
 
@@ -70,7 +62,7 @@ struct UniformPostprocessingBuffer {
 
 
 struct AtomicCounterBuffer {
-    uint32_t counter;
+    uint32_t counters[2]; // Compacted draws of the early and the late culling phase
 };
 
 
@@ -79,6 +71,17 @@ struct DrawCommandsBuffer {
     std::vector<VkDrawIndexedIndirectCommand> commands{};
 };
 
+// Far band instances, drawn with one vkCmdDrawIndirect of a quad per instance
+struct ImpostorList {
+    VkDrawIndirectCommand command;
+    // Followed by the instance index of every impostor
+};
+
+// Non-empty draw after compaction, gl_DrawID is its slot in the compacted list
+struct CompactedDrawCommand {
+    VkDrawIndexedIndirectCommand command;
+};
+
 
 
 struct MatrixBufferObject {
@@ -92,6 +95,7 @@ struct MatrixDataBufferObject {
     std::vector<glm::vec4> rot;
     std::vector<glm::vec4> scl;
     std::vector<glm::vec4> sphere;
+    std::vector<glm::vec4> packed; // pos, rot, scl per instance, as modelDataBuffers hold them
     bool dirty2 = true;
     size_t frame = 0;
 };
@@ -115,12 +115,12 @@ struct KeyListener {
         // Reload shaders
         keyMap.emplace(SDL_SCANCODE_F3, KeyBinding(
         [](Engine &engine) {
-            const std::vector<std::filesystem::path> dirtyShaders = Shaders::getShadersToCompile();
-            for (auto& dirtyShader : dirtyShaders) {
-                auto shader = Shaders::compileShader(dirtyShader);
-                vkDeviceWaitIdle(engine.device);
-                Shaders::saveShaderToFile(Tools::getShaderPath() + "compiled/" + dirtyShader.lexically_relative(Tools::getShaderPath()).replace_extension(".spv").string(), shader);
-                if (dirtyShader.string().contains("postprocessing")) engine.graphicsManager.recreatePostprocessingPipeline(dirtyShader.filename().replace_extension(".spv"));
+            const std::vector<std::filesystem::path> compiledShaders = Shaders::compileShaders();
+            if (compiledShaders.empty()) return;
+
+            engine.graphicsManager.reloadShaderArchive();
+            for (auto compiledShader : compiledShaders) {
+                if (compiledShader.string().contains("postprocessing")) engine.graphicsManager.recreatePostprocessingPipeline(compiledShader.filename().replace_extension(".spv"));
             }
         }));
     }
@@ -16,6 +16,9 @@ struct LogicalDevice {
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+        if (indices.transferFamily.has_value()) {
+            uniqueQueueFamilies.insert(indices.transferFamily.value());
+        }
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -47,6 +50,7 @@ struct LogicalDevice {
         features12.descriptorBindingPartiallyBound = VK_TRUE;
         features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
         features12.bufferDeviceAddress = VK_TRUE;
+        features12.timelineSemaphore = VK_TRUE;
         features12.pNext = &sync2;
 
 
@@ -93,7 +97,7 @@ struct LogicalDevice {
             throw std::runtime_error("failed to create logical device!");
         }
 
-        vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &graphicsQueue);
+        vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
         vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
     }
 };
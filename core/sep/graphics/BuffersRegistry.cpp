@@ -4,6 +4,8 @@
 
 #include "BuffersRegistry.hpp"
 
+#include <algorithm>
+
 #include "Vertex.hpp"
 #include "ModelEntityManager.hpp"
 
@@ -11,7 +13,7 @@
 void BuffersRegistry::createBuffer(
     VkDevice device, VkPhysicalDevice physicalDevice,
     VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-    VkBuffer& buffer, VkDeviceMemory& bufferMemory
+    VkBuffer& buffer, GpuAllocation& bufferMemory
     ) {
 
     VkBufferCreateInfo bufferInfo{};
@@ -28,42 +30,19 @@ void BuffersRegistry::createBuffer(
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
 
-    VkMemoryAllocateFlagsInfo allocFlagsInfo{};
-    allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
-    allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
-
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = Helper::findMemoryType(memRequirements.memoryTypeBits, properties, physicalDevice);
-    allocInfo.pNext = &allocFlagsInfo;
+    bufferMemory = GpuAllocator::allocate(device, physicalDevice, memRequirements, properties, GpuResourceKind::Linear);
 
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate buffer memory!");
-    }
-
-    vkBindBufferMemory(device, buffer, bufferMemory, 0);
+    vkBindBufferMemory(device, buffer, bufferMemory.memory, bufferMemory.offset);
 }
 
-void BuffersRegistry::copyBuffer(
-    VkDevice device,
-    VkCommandPool commandPool, VkQueue graphicsQueue,
-    VkBuffer srcBuffer, VkBuffer dstBuffer,
-    VkDeviceSize size
-    ) {
-
-    const VkCommandBuffer& commandBuffer = Command::beginSingleTimeCommands(device, commandPool);
-
-    VkBufferCopy copyRegion{};
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-    Command::endSingleTimeCommands(device, commandBuffer, commandPool, graphicsQueue);
+void BuffersRegistry::destroyBuffer(VkDevice device, VkBuffer buffer, const GpuAllocation& bufferMemory) {
+    vkDestroyBuffer(device, buffer, nullptr);
+    GpuAllocator::free(device, bufferMemory);
 }
 
 void BuffersRegistry::createGenericBuffers(
     VkDevice device, VkPhysicalDevice physicalDevice,
-    std::vector<VkBuffer>& buffers, std::vector<VkDeviceMemory>& buffersMemory, std::vector<void*>& buffersMapped,
+    std::vector<VkBuffer>& buffers, std::vector<GpuAllocation>& buffersMemory, std::vector<void*>& buffersMapped,
     size_t MAX_FRAMES_IN_FLIGHT, VkDeviceSize bufferSize, int usageFlags, int memoryFlags
     ) {
 
@@ -74,14 +53,14 @@ void BuffersRegistry::createGenericBuffers(
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         createBuffer(device, physicalDevice, bufferSize, usageFlags, memoryFlags, buffers[i], buffersMemory[i]);
 
-        vkMapMemory(device, buffersMemory[i], 0, bufferSize, 0, &buffersMapped[i]);
+        buffersMapped[i] = buffersMemory[i].mapped;
     }
 }
 
 void BuffersRegistry::createGenericBuffers(
     VkDevice device, VkPhysicalDevice physicalDevice,
     std::vector<uint64_t>& constants,
-    std::vector<VkBuffer>& buffers, std::vector<VkDeviceMemory>& buffersMemory, std::vector<void*>& buffersMapped,
+    std::vector<VkBuffer>& buffers, std::vector<GpuAllocation>& buffersMemory, std::vector<void*>& buffersMapped,
     size_t MAX_FRAMES_IN_FLIGHT, VkDeviceSize bufferSize, int usageFlags, int memoryFlags
     ) {
 
@@ -92,7 +71,7 @@ void BuffersRegistry::createGenericBuffers(
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         createBuffer(device, physicalDevice, bufferSize, usageFlags, memoryFlags, buffers[i], buffersMemory[i]);
-        vkMapMemory(device, buffersMemory[i], 0, bufferSize, 0, &buffersMapped[i]);
+        buffersMapped[i] = buffersMemory[i].mapped;
 
         VkBufferDeviceAddressInfoKHR address_info{VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR};
         address_info.buffer = buffers[i];
@@ -103,25 +82,25 @@ void BuffersRegistry::createGenericBuffers(
 
 void BuffersRegistry::createGenericBuffer(
         VkDevice device, VkPhysicalDevice physicalDevice,
-        VkBuffer& buffer, VkDeviceMemory& bufferMemory, void*& bufferMapped,
+        VkBuffer& buffer, GpuAllocation& bufferMemory, void*& bufferMapped,
         VkDeviceSize bufferSize, int usageFlags, int memoryFlags
         ) {
 
     createBuffer(device, physicalDevice, bufferSize, usageFlags, memoryFlags, buffer, bufferMemory);
 
-    vkMapMemory(device, bufferMemory, 0, bufferSize, 0, &bufferMapped);
+    bufferMapped = bufferMemory.mapped;
 }
 
 void BuffersRegistry::createGenericBuffer(
         VkDevice device, VkPhysicalDevice physicalDevice,
         uint64_t& constant,
-        VkBuffer& buffer, VkDeviceMemory& bufferMemory, void*& bufferMapped,
+        VkBuffer& buffer, GpuAllocation& bufferMemory, void*& bufferMapped,
         VkDeviceSize bufferSize, int usageFlags, int memoryFlags
         ) {
 
     createBuffer(device, physicalDevice, bufferSize, usageFlags, memoryFlags, buffer, bufferMemory);
 
-    vkMapMemory(device, bufferMemory, 0, bufferSize, 0, &bufferMapped);
+    bufferMapped = bufferMemory.mapped;
 
     VkBufferDeviceAddressInfoKHR address_info{VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR};
     address_info.buffer = buffer;
@@ -151,55 +130,59 @@ void BuffersRegistry::createCommandBuffer(
     }
 }
 
-void BuffersRegistry::createVertexBuffer(
+UploadService::Ticket BuffersRegistry::createVertexBuffer(
         VkDevice device, VkPhysicalDevice physicalDevice,
-        VkCommandPool commandPool, VkQueue graphicsQueue,
-        VkBuffer& vertexBuffer, VkDeviceMemory& vertexBufferMemory,
+        UploadService& uploads,
+        VkBuffer& vertexBuffer, GpuAllocation& vertexBufferMemory,
         const ModelEntityManager& mem) {
 
     const VkDeviceSize bufferSize = mem.getVertexBufferSize();
 
-    VkBuffer stagingBuffer{};
-    VkDeviceMemory stagingBufferMemory{};
-    createBuffer(device, physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+    const UploadService::Staging staging = uploads.stage(bufferSize);
 
     const std::vector<Vertex> vertices = mem.getAllVertices();
-    void* data;
-    vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-
-    memcpy(data, vertices.data(), bufferSize);
-    vkUnmapMemory(device, stagingBufferMemory);
+    memcpy(staging.mapped, vertices.data(), bufferSize);
 
     createBuffer(device, physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
 
-    copyBuffer(device, commandPool, graphicsQueue, stagingBuffer, vertexBuffer, bufferSize);
-
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    return uploads.copy(staging, vertexBuffer, 0, bufferSize);
 }
 
-void BuffersRegistry::createIndexBuffer(
+UploadService::Ticket BuffersRegistry::createIndexBuffer(
         VkDevice device, VkPhysicalDevice physicalDevice,
-        VkCommandPool commandPool, VkQueue graphicsQueue,
-        VkBuffer& indexBuffer, VkDeviceMemory& indexBufferMemory,
+        UploadService& uploads,
+        VkBuffer& indexBuffer, GpuAllocation& indexBufferMemory,
         const ModelEntityManager& mem
         ) {
 
     const VkDeviceSize bufferSize = mem.getIndexBufferSize();
 
-    VkBuffer stagingBuffer{};
-    VkDeviceMemory stagingBufferMemory{};
-    createBuffer(device, physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+    const UploadService::Staging staging = uploads.stage(bufferSize);
 
     const std::vector<u_int32_t> indices = mem.getAllIndices();
-    void* data;
-    vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, indices.data(), bufferSize);
-    vkUnmapMemory(device, stagingBufferMemory);
+    memcpy(staging.mapped, indices.data(), bufferSize);
 
     createBuffer(device, physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
-    copyBuffer(device, commandPool, graphicsQueue, stagingBuffer, indexBuffer, bufferSize);
 
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    return uploads.copy(staging, indexBuffer, 0, bufferSize);
+}
+
+UploadService::Ticket BuffersRegistry::createMaterialBuffer(
+        VkDevice device, VkPhysicalDevice physicalDevice,
+        UploadService& uploads,
+        uint64_t& constant,
+        VkBuffer& materialBuffer, GpuAllocation& materialBufferMemory,
+        const ModelEntityManager& mem
+        ) {
+
+    const std::vector<uint32_t> materials = mem.getAllMaterials();
+    const VkDeviceSize bufferSize = sizeof(uint32_t) * std::max<size_t>(materials.size(), 1);
+
+    const UploadService::Staging staging = uploads.stage(bufferSize);
+    memcpy(staging.mapped, materials.data(), sizeof(uint32_t) * materials.size());
+
+    void* mapped = nullptr;
+    createGenericBuffer(device, physicalDevice, constant, materialBuffer, materialBufferMemory, mapped, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    return uploads.copy(staging, materialBuffer, 0, bufferSize);
 }
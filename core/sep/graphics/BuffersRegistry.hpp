@@ -11,7 +11,9 @@
 #include <stdexcept>
 
 #include "Command.hpp"
+#include "GpuAllocator.hpp"
 #include "Helper.hpp"
+#include "UploadService.hpp"
 
 
 struct ModelEntityManager;
@@ -21,40 +23,35 @@ struct BuffersRegistry {
     static void createBuffer(
         VkDevice device, VkPhysicalDevice physicalDevice,
         VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-        VkBuffer& buffer, VkDeviceMemory& bufferMemory
+        VkBuffer& buffer, GpuAllocation& bufferMemory
         );
 
-    static void copyBuffer(
-        VkDevice device,
-        VkCommandPool commandPool, VkQueue graphicsQueue,
-        VkBuffer srcBuffer, VkBuffer dstBuffer,
-        VkDeviceSize size
-        );
+    static void destroyBuffer(VkDevice device, VkBuffer buffer, const GpuAllocation& bufferMemory);
 
     static void createGenericBuffers(
         VkDevice device, VkPhysicalDevice physicalDevice,
-        std::vector<VkBuffer>& buffers, std::vector<VkDeviceMemory>& buffersMemory, std::vector<void*>& buffersMapped,
+        std::vector<VkBuffer>& buffers, std::vector<GpuAllocation>& buffersMemory, std::vector<void*>& buffersMapped,
         size_t MAX_FRAMES_IN_FLIGHT, VkDeviceSize bufferSize, int usageFlags, int memoryFlags
         );
 
     static void createGenericBuffers(
         VkDevice device, VkPhysicalDevice physicalDevice,
         std::vector<uint64_t>& constants,
-        std::vector<VkBuffer>& buffers, std::vector<VkDeviceMemory>& buffersMemory, std::vector<void*>& buffersMapped,
+        std::vector<VkBuffer>& buffers, std::vector<GpuAllocation>& buffersMemory, std::vector<void*>& buffersMapped,
         size_t MAX_FRAMES_IN_FLIGHT, VkDeviceSize bufferSize, int usageFlags, int memoryFlags
         );
 
 
     static void createGenericBuffer(
         VkDevice device, VkPhysicalDevice physicalDevice,
-        VkBuffer& buffer, VkDeviceMemory& bufferMemory, void*& bufferMapped,
+        VkBuffer& buffer, GpuAllocation& bufferMemory, void*& bufferMapped,
         VkDeviceSize bufferSize, int usageFlags, int memoryFlags
         );
 
     static void createGenericBuffer(
         VkDevice device, VkPhysicalDevice physicalDevice,
         uint64_t& constant,
-        VkBuffer& buffer, VkDeviceMemory& bufferMemory, void*& bufferMapped,
+        VkBuffer& buffer, GpuAllocation& bufferMemory, void*& bufferMapped,
         VkDeviceSize bufferSize, int usageFlags, int memoryFlags
         );
 
@@ -66,16 +63,26 @@ struct BuffersRegistry {
         size_t MAX_FRAMES_IN_FLIGHT
         );
 
-    static void createVertexBuffer(
+    // All return the upload's ticket, the buffers can't be read before it completed
+    static UploadService::Ticket createVertexBuffer(
         VkDevice device, VkPhysicalDevice physicalDevice,
-        VkCommandPool commandPool, VkQueue graphicsQueue,
-        VkBuffer& vertexBuffer, VkDeviceMemory& vertexBufferMemory,
+        UploadService& uploads,
+        VkBuffer& vertexBuffer, GpuAllocation& vertexBufferMemory,
         const ModelEntityManager& mem);
 
-    static void createIndexBuffer(
+    static UploadService::Ticket createIndexBuffer(
         VkDevice device, VkPhysicalDevice physicalDevice,
-        VkCommandPool commandPool, VkQueue graphicsQueue,
-        VkBuffer& indexBuffer, VkDeviceMemory& indexBufferMemory,
+        UploadService& uploads,
+        VkBuffer& indexBuffer, GpuAllocation& indexBufferMemory,
+        const ModelEntityManager& mem
+        );
+
+    // One texture slot per vertex, the vertex shader reads it at gl_VertexIndex
+    static UploadService::Ticket createMaterialBuffer(
+        VkDevice device, VkPhysicalDevice physicalDevice,
+        UploadService& uploads,
+        uint64_t& constant,
+        VkBuffer& materialBuffer, GpuAllocation& materialBufferMemory,
         const ModelEntityManager& mem
         );
 };
@@ -0,0 +1,125 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#include "CullingValidation.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "Barrier.h"
+#include "BuffersRegistry.hpp"
+#include "FrustumCuller.hpp"
+#include "Logger.hpp"
+
+
+void CullingValidation::initialize(const size_t frames) {
+    buffers.assign(frames, VK_NULL_HANDLE);
+    memory.assign(frames, GpuAllocation{});
+    mapped.assign(frames, nullptr);
+    sizes.assign(frames, 0);
+    expected.assign(frames, Expected{});
+}
+
+void CullingValidation::begin(
+    VkDevice device, VkPhysicalDevice physicalDevice, const uint32_t slot, const VkDeviceSize listsSize,
+    const std::vector<CullingData>& objects, const size_t count, const UniformCullingBuffer& culling, const ShaderSpecialization& specialization,
+    const std::vector<VkDrawIndexedIndirectCommand>& commands
+    ) {
+
+    if (frame++ % INTERVAL != 0) return;
+
+    // Nothing on the gpu uses the slot's readback anymore, check() already consumed it
+    if (const VkDeviceSize size = sizeof(Header) + listsSize; sizes[slot] < size) {
+        if (buffers[slot] != VK_NULL_HANDLE) BuffersRegistry::destroyBuffer(device, buffers[slot], memory[slot]);
+
+        BuffersRegistry::createGenericBuffer(
+            device, physicalDevice, buffers[slot], memory[slot], mapped[slot], size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+        sizes[slot] = size;
+    }
+
+    std::vector<VkDrawIndexedIndirectCommand> hostCommands = commands;
+    std::vector<uint32_t> visibleIndices{};
+    std::vector<uint32_t> impostorIndices{};
+    FrustumCuller::cull(objects, count, culling, specialization, hostCommands, visibleIndices, impostorIndices);
+
+    Expected& slotExpected = expected[slot];
+    slotExpected.pending = true;
+    slotExpected.listsSize = listsSize;
+    slotExpected.meshInstances = 0;
+    for (const auto& command : hostCommands) slotExpected.meshInstances += command.instanceCount;
+    slotExpected.impostors = static_cast<uint32_t>(impostorIndices.size());
+}
+
+void CullingValidation::record(VkCommandBuffer commandBuffer, const uint32_t slot, VkBuffer impostorBuffer, VkBuffer counterBuffer, VkBuffer compactedBuffer, const VkDeviceSize listsSize) const {
+    if (!expected[slot].pending) return;
+
+    Barrier toCopy(commandBuffer);
+    for (VkBuffer buffer : {impostorBuffer, counterBuffer, compactedBuffer}) {
+        toCopy.buffer(
+            buffer,
+            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+            VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            0, VK_WHOLE_SIZE
+        );
+    }
+    toCopy.apply();
+
+    const VkBufferCopy impostors{0, offsetof(Header, impostors), sizeof(VkDrawIndirectCommand)};
+    const VkBufferCopy counts{0, offsetof(Header, counts), sizeof(AtomicCounterBuffer)};
+    const VkBufferCopy lists{0, sizeof(Header), listsSize};
+    vkCmdCopyBuffer(commandBuffer, impostorBuffer, buffers[slot], 1, &impostors);
+    vkCmdCopyBuffer(commandBuffer, counterBuffer, buffers[slot], 1, &counts);
+    vkCmdCopyBuffer(commandBuffer, compactedBuffer, buffers[slot], 1, &lists);
+
+    Barrier toHost(commandBuffer);
+    toHost.buffer(
+        buffers[slot],
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_HOST_READ_BIT,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_HOST_BIT,
+        0, VK_WHOLE_SIZE
+    ).apply();
+}
+
+void CullingValidation::check(const uint32_t slot) {
+    Expected& slotExpected = expected[slot];
+    if (!slotExpected.pending) return;
+    slotExpected.pending = false;
+
+    const auto* data = static_cast<const char*>(mapped[slot]);
+
+    Header header{};
+    memcpy(&header, data, sizeof(header));
+
+    // Early list first, the late one halfway through
+    uint64_t meshInstances = 0;
+    for (uint32_t phase = 0; phase < 2; ++phase) {
+        const char* list = data + sizeof(Header) + slotExpected.listsSize / 2 * phase;
+        const uint32_t draws = std::min<uint64_t>(header.counts.counters[phase], slotExpected.listsSize / 2 / sizeof(CompactedDrawCommand));
+
+        for (uint32_t i = 0; i < draws; ++i) {
+            CompactedDrawCommand draw{};
+            memcpy(&draw, list + sizeof(CompactedDrawCommand) * i, sizeof(draw));
+            meshInstances += draw.command.instanceCount;
+        }
+    }
+
+    Logger LOGGER{"CullingValidation"};
+    if (header.impostors.instanceCount != slotExpected.impostors) {
+        LOGGER.warn("Gpu culled ${} impostors, host ${}", header.impostors.instanceCount, slotExpected.impostors);
+    }
+    if (meshInstances > slotExpected.meshInstances) {
+        LOGGER.warn("Gpu drew ${} mesh instances, host frustum culling keeps only ${}", meshInstances, slotExpected.meshInstances);
+    }
+}
+
+void CullingValidation::cleanup(VkDevice device) const {
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        if (buffers[i] != VK_NULL_HANDLE) BuffersRegistry::destroyBuffer(device, buffers[i], memory[i]);
+    }
+}
@@ -0,0 +1,62 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_CULLINGVALIDATION_H
+#define INC_2G43S_CULLINGVALIDATION_H
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "GpuAllocator.hpp"
+#include "ShaderSpecialization.hpp"
+#include "Types.hpp"
+
+// Debug builds check gpu culling against FrustumCuller every few frames. The frame's impostor list, draw counts and
+// compacted draws are copied to host memory and compared once the frame slot comes around again. Impostors skip
+// occlusion so both sides have to agree on their count, Hi-Z only ever removes meshes so the gpu may draw fewer
+struct CullingValidation {
+    static constexpr uint32_t INTERVAL = 64; // Frames between checks, the host side is a full cull
+
+    // Readback layout, followed by the compacted early and late lists
+    struct Header {
+        VkDrawIndirectCommand impostors;
+        AtomicCounterBuffer counts;
+    };
+
+    struct Expected {
+        bool pending = false;
+        VkDeviceSize listsSize = 0; // Both compacted lists, the late one starts halfway
+        uint64_t meshInstances = 0;
+        uint32_t impostors = 0;
+    };
+
+    std::vector<VkBuffer> buffers{};
+    std::vector<GpuAllocation> memory{};
+    std::vector<void*> mapped{};
+    std::vector<VkDeviceSize> sizes{};
+    std::vector<Expected> expected{};
+
+    uint64_t frame = 0;
+
+    void initialize(size_t frames);
+
+    // Host cull of what the gpu is about to cull in slot, every INTERVAL frames. Grows the slot's readback if needed
+    void begin(
+        VkDevice device, VkPhysicalDevice physicalDevice, uint32_t slot, VkDeviceSize listsSize,
+        const std::vector<CullingData>& objects, size_t count, const UniformCullingBuffer& culling, const ShaderSpecialization& specialization,
+        const std::vector<VkDrawIndexedIndirectCommand>& commands
+        );
+
+    // After the late draws, copies the slot's culling output into the readback
+    void record(VkCommandBuffer commandBuffer, uint32_t slot, VkBuffer impostorBuffer, VkBuffer counterBuffer, VkBuffer compactedBuffer, VkDeviceSize listsSize) const;
+
+    // The slot's last submit has to be finished
+    void check(uint32_t slot);
+
+    void cleanup(VkDevice device) const;
+};
+
+
+#endif //INC_2G43S_CULLINGVALIDATION_H
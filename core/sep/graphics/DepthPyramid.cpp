@@ -0,0 +1,128 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#include "DepthPyramid.hpp"
+
+#include <algorithm>
+
+#include "Barrier.h"
+#include "BuffersRegistry.hpp"
+#include "DepthPyramidPushConstants.hpp"
+
+
+void DepthPyramid::resize(VkDevice device, VkPhysicalDevice physicalDevice, const VkExtent2D extent, const VkFormat depthFormat) {
+    if (buffer != VK_NULL_HANDLE && extent.width == this->extent.width && extent.height == this->extent.height) return;
+
+    cleanup(device);
+
+    this->extent = extent;
+    unorm24 = depthFormat == VK_FORMAT_D24_UNORM_S8_UINT || depthFormat == VK_FORMAT_X8_D24_UNORM_PACK32;
+
+    // Ceil halving, so every texel covers its whole footprint in the level above
+    uint32_t offset = extent.width * extent.height;
+    uint32_t width = extent.width;
+    uint32_t height = extent.height;
+
+    levelCount = 0;
+    while (levelCount < MAX_LEVELS && (width > 1 || height > 1)) {
+        width = std::max(1u, (width + 1) / 2);
+        height = std::max(1u, (height + 1) / 2);
+
+        levels[levelCount++] = {offset, width, height};
+        offset += width * height;
+    }
+
+    void* mapped = nullptr;
+    BuffersRegistry::createGenericBuffer(
+        device, physicalDevice, constant, buffer, memory, mapped,
+        sizeof(uint32_t) * std::max(offset, 1u),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+}
+
+void DepthPyramid::record(VkCommandBuffer commandBuffer, VkImage depthImage, VkPipeline pipeline, VkPipelineLayout pipelineLayout) const {
+    // Last frame's culling may still read the buffer
+    Barrier toCopy(commandBuffer);
+    toCopy.image(
+        depthImage,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+        VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT
+    ).buffer(
+        buffer,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        0, VK_WHOLE_SIZE
+    ).apply();
+
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {extent.width, extent.height, 1};
+
+    vkCmdCopyImageToBuffer(commandBuffer, depthImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+
+    Barrier copied(commandBuffer);
+    copied.image(
+        depthImage,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        VK_ACCESS_2_TRANSFER_READ_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+        VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT
+    ).buffer(
+        buffer,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_SHADER_READ_BIT,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        0, VK_WHOLE_SIZE
+    ).apply();
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+    // One dispatch per level, each reads what the previous one wrote
+    uint32_t srcOffset = 0;
+    uint32_t srcWidth = extent.width;
+    uint32_t srcHeight = extent.height;
+
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        const Level& level = levels[i];
+
+        DepthPyramidPushConstants constants{};
+        constants.pyramid = constant;
+        constants.srcOffset = srcOffset;
+        constants.srcWidth = srcWidth;
+        constants.srcHeight = srcHeight;
+        constants.dstOffset = level.offset;
+        constants.dstWidth = level.width;
+        constants.dstHeight = level.height;
+        constants.unorm24 = i == 0 && unorm24;
+
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DepthPyramidPushConstants), &constants);
+        vkCmdDispatch(commandBuffer, (level.width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, (level.height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+
+        Barrier built(commandBuffer);
+        built.buffer(
+            buffer,
+            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+            VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_2_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            0, VK_WHOLE_SIZE
+        ).apply();
+
+        srcOffset = level.offset;
+        srcWidth = level.width;
+        srcHeight = level.height;
+    }
+}
+
+void DepthPyramid::cleanup(VkDevice device) const {
+    if (buffer == VK_NULL_HANDLE) return;
+
+    BuffersRegistry::destroyBuffer(device, buffer, memory);
+}
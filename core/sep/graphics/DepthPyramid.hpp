@@ -0,0 +1,49 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_DEPTHPYRAMID_H
+#define INC_2G43S_DEPTHPYRAMID_H
+
+#include <array>
+#include <cstdint>
+#include <vulkan/vulkan_core.h>
+
+#include "GpuAllocator.hpp"
+
+// Farthest depth mip chain (Hi-Z) of the depth buffer in one storage buffer, culling reads it through its address.
+// The depth image is copied to the front of the buffer, level 0 is half of that and every level halves again
+struct DepthPyramid {
+    static constexpr uint32_t MAX_LEVELS = 16;
+    static constexpr uint32_t WORKGROUP_SIZE = 8;
+
+    // Laid out like a uvec4, offsets and sizes are in texels
+    struct Level {
+        uint32_t offset = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t _pad = 0;
+    };
+
+    VkBuffer buffer{};
+    GpuAllocation memory{};
+    uint64_t constant{};
+
+    VkExtent2D extent{};
+    bool unorm24 = false; // D24 copies out as unorm in the low 24 bits, D32 as float
+
+    std::array<Level, MAX_LEVELS> levels{};
+    uint32_t levelCount = 0;
+
+    // Rebuilds the chain for a new depth extent, nothing on the gpu may use the old buffer anymore
+    void resize(VkDevice device, VkPhysicalDevice physicalDevice, VkExtent2D extent, VkFormat depthFormat);
+
+    // Depth has to come out of its rendering in DEPTH_STENCIL_ATTACHMENT_OPTIMAL, it's back there afterwards.
+    // The pyramid is readable by compute shaders once this is recorded
+    void record(VkCommandBuffer commandBuffer, VkImage depthImage, VkPipeline pipeline, VkPipelineLayout pipelineLayout) const;
+
+    void cleanup(VkDevice device) const;
+};
+
+
+#endif //INC_2G43S_DEPTHPYRAMID_H
@@ -0,0 +1,151 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#include "FrustumCuller.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define FRUSTUM_CULLER_SSE
+#endif
+
+
+glm::mat4 FrustumCuller::instanceMatrix(const glm::vec4 pos, const glm::vec4 rot, const glm::vec4 scl) {
+    const glm::vec4 q = glm::normalize(rot);
+    const float x = q.x;
+    const float y = q.y;
+    const float z = q.z;
+    const float w = q.w;
+
+    // Same column major constructor as the shader, so the same (transposed looking) rotation
+    const glm::mat4 rotation(
+        1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y - w * z), 2.0f * (x * z + w * y), 0.0f,
+        2.0f * (x * y + w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z - w * x), 0.0f,
+        2.0f * (x * z - w * y), 2.0f * (y * z + w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    );
+
+    glm::mat4 translation(1.0f);
+    translation[3] = glm::vec4(glm::vec3(pos), 1.0f);
+
+    return translation * rotation * glm::scale(glm::mat4(1.0f), glm::vec3(scl));
+}
+
+glm::vec4 FrustumCuller::worldSphere(const glm::vec4 sphere, const glm::mat4& model) {
+    const glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(sphere), 1.0f));
+    const float scale = std::max({
+        glm::length(glm::vec3(model[0])),
+        glm::length(glm::vec3(model[1])),
+        glm::length(glm::vec3(model[2]))
+    });
+
+    return glm::vec4(center, sphere.w * scale);
+}
+
+bool FrustumCuller::isSphereInFrustum(const glm::vec4 sphere, const glm::vec4 (&planes)[6]) {
+    const glm::vec3 center = glm::vec3(sphere);
+    for (const glm::vec4& plane : planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -sphere.w) return false;
+    }
+
+    return true;
+}
+
+FrustumCuller::Band FrustumCuller::band(const glm::vec4 sphere, const uint32_t drawCommand, const UniformCullingBuffer& culling, const ShaderSpecialization& specialization) {
+    if (!specialization.culling) return Band::MESH;
+
+    const glm::mat4& viewProjection = culling.viewProjection;
+    const float depth = viewProjection[0][3] * sphere.x + viewProjection[1][3] * sphere.y + viewProjection[2][3] * sphere.z + viewProjection[3][3];
+    if (depth <= sphere.w) return Band::MESH;
+
+    if (sphere.w * culling.pixelScale < culling.minPixelRadius * depth) return Band::DROPPED;
+
+    const bool distant = culling.impostorDistance > 0.0f && depth > culling.impostorDistance;
+    return specialization.lodCount > 1 && distant && drawCommand < culling.impostorRows ? Band::IMPOSTOR : Band::MESH;
+}
+
+void FrustumCuller::cull(
+    const std::vector<CullingData>& objects, size_t count, const UniformCullingBuffer& culling, const ShaderSpecialization& specialization,
+    std::vector<VkDrawIndexedIndirectCommand>& commands, std::vector<uint32_t>& visibleIndices, std::vector<uint32_t>& impostorIndices
+    ) {
+
+    const auto& planes = culling.planes;
+
+    count = std::min(count, objects.size());
+    visibleIndices.resize(count);
+    impostorIndices.clear();
+    for (auto& command : commands) command.instanceCount = 0;
+
+    auto emit = [&](const uint32_t index) {
+        const uint32_t drawCommand = objects[index].drawCommandIndex;
+        if (drawCommand >= commands.size()) return;
+
+        switch (band(objects[index].sphere, drawCommand, culling, specialization)) {
+            case Band::DROPPED:
+                return;
+            case Band::IMPOSTOR:
+                impostorIndices.emplace_back(index);
+                return;
+            case Band::MESH:
+                break;
+        }
+
+        auto& command = commands[drawCommand];
+        const size_t slot = static_cast<size_t>(command.firstInstance) + command.instanceCount;
+        if (slot >= visibleIndices.size()) return;
+
+        visibleIndices[slot] = index;
+        command.instanceCount++;
+    };
+
+    size_t i = 0;
+
+    // Culling off draws everything, like the shader with CULLING false
+    if (!specialization.culling) {
+        for (; i < count; ++i) emit(static_cast<uint32_t>(i));
+        return;
+    }
+
+#ifdef FRUSTUM_CULLER_SSE
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int p = 0; p < 6; ++p) {
+        planeX[p] = _mm_set1_ps(planes[p].x);
+        planeY[p] = _mm_set1_ps(planes[p].y);
+        planeZ[p] = _mm_set1_ps(planes[p].z);
+        planeW[p] = _mm_set1_ps(planes[p].w);
+    }
+
+    for (; i + 4 <= count; i += 4) {
+        // Four spheres in, x, y, z and radius of all four out
+        __m128 x = _mm_loadu_ps(&objects[i + 0].sphere.x);
+        __m128 y = _mm_loadu_ps(&objects[i + 1].sphere.x);
+        __m128 z = _mm_loadu_ps(&objects[i + 2].sphere.x);
+        __m128 r = _mm_loadu_ps(&objects[i + 3].sphere.x);
+        _MM_TRANSPOSE4_PS(x, y, z, r);
+
+        const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+
+        __m128 inside{};
+        for (int p = 0; p < 6; ++p) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(planeX[p], x), planeW[p]);
+            distance = _mm_add_ps(distance, _mm_mul_ps(planeY[p], y));
+            distance = _mm_add_ps(distance, _mm_mul_ps(planeZ[p], z));
+
+            const __m128 front = _mm_cmpge_ps(distance, negativeRadius);
+            inside = p == 0 ? front : _mm_and_ps(inside, front);
+        }
+
+        // Lanes in order, so indices inside a command come out sorted like on the scalar path
+        for (auto mask = static_cast<unsigned>(_mm_movemask_ps(inside)); mask != 0; mask &= mask - 1) {
+            emit(static_cast<uint32_t>(i + std::countr_zero(mask)));
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (isSphereInFrustum(objects[i].sphere, planes)) emit(static_cast<uint32_t>(i));
+    }
+}
@@ -0,0 +1,47 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_FRUSTUMCULLER_H
+#define INC_2G43S_FRUSTUMCULLER_H
+
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "glmMath.h"
+#include "ShaderSpecialization.hpp"
+#include "Types.hpp"
+
+// Host twin of culling.comp over the same CullingData, for checking what the gpu culled and as the culling pass
+// on software drivers. Spheres are tested four at a time with SSE, other targets take the scalar path.
+// Takes the specialization the culling pipeline was built with, so culling and lodCount mean the same on both sides
+struct FrustumCuller {
+    enum class Band {
+        MESH,
+        IMPOSTOR,
+        DROPPED // Below the pixel threshold
+    };
+
+    // The matrix matrices.comp builds from an instance's pos, rot (quaternion, xyzw) and scl
+    static glm::mat4 instanceMatrix(glm::vec4 pos, glm::vec4 rot, glm::vec4 scl);
+
+    // Model space bounding sphere into world space, the radius grows with the largest axis scale
+    static glm::vec4 worldSphere(glm::vec4 sphere, const glm::mat4& model);
+
+    // Planes point inwards, a sphere is culled once it's fully behind any of them
+    static bool isSphereInFrustum(glm::vec4 sphere, const glm::vec4 (&planes)[6]);
+
+    // Screen size and distance band of a world sphere, spheres around the camera are always meshes
+    static Band band(glm::vec4 sphere, uint32_t drawCommand, const UniformCullingBuffer& culling, const ShaderSpecialization& specialization);
+
+    // Sets instanceCount of every command and writes the visible instance indices from the command's firstInstance on,
+    // the same output culling.comp produces. Visible far band instances go to impostorIndices instead.
+    // The gpu orders indices inside a command and impostors arbitrarily, compare them as sets
+    static void cull(
+        const std::vector<CullingData>& objects, size_t count, const UniformCullingBuffer& culling, const ShaderSpecialization& specialization,
+        std::vector<VkDrawIndexedIndirectCommand>& commands, std::vector<uint32_t>& visibleIndices, std::vector<uint32_t>& impostorIndices
+        );
+};
+
+
+#endif //INC_2G43S_FRUSTUMCULLER_H
@@ -0,0 +1,222 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#include "GpuAllocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include "Helper.hpp"
+
+
+GpuAllocation GpuAllocator::allocate(
+    VkDevice device, VkPhysicalDevice physicalDevice,
+    const VkMemoryRequirements& requirements, const VkMemoryPropertyFlags properties, const GpuResourceKind kind
+    ) {
+
+    std::lock_guard lock(mutex);
+
+    if (!propertiesQueried) {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+        propertiesQueried = true;
+    }
+
+    GpuAllocation allocation{};
+    allocation.memoryType = Helper::findMemoryType(requirements.memoryTypeBits, properties, physicalDevice);
+    allocation.size = requirements.size;
+
+    if (requirements.size >= DEDICATED_THRESHOLD) {
+        allocation.memory = allocateMemory(device, requirements.size, allocation.memoryType, &allocation.mapped);
+        allocation.block = GpuAllocation::DEDICATED;
+
+        dedicatedCount++;
+        dedicatedBytes += requirements.size;
+        return allocation;
+    }
+
+    auto place = [&](const uint32_t index) {
+        Block& block = blocks[index];
+        if (block.memory == VK_NULL_HANDLE || block.memoryType != allocation.memoryType || block.kind != kind) return false;
+        if (!suballocate(block, requirements, allocation.offset)) return false;
+
+        block.allocations++;
+        allocation.memory = block.memory;
+        allocation.block = index;
+        allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + allocation.offset : nullptr;
+        return true;
+    };
+
+    for (uint32_t i = 0; i < blocks.size(); ++i) {
+        if (place(i)) return allocation;
+    }
+
+    // New block, reusing a released slot keeps block indices of live allocations stable
+    auto slot = static_cast<uint32_t>(std::ranges::find_if(blocks, [](const Block& block) { return block.memory == VK_NULL_HANDLE; }) - blocks.begin());
+    if (slot == blocks.size()) blocks.emplace_back();
+
+    Block& block = blocks[slot];
+    block.size = BLOCK_SIZE;
+    block.memoryType = allocation.memoryType;
+    block.kind = kind;
+    block.memory = allocateMemory(device, BLOCK_SIZE, allocation.memoryType, &block.mapped);
+    block.free = {{0, BLOCK_SIZE}};
+    block.allocations = 0;
+
+    if (!place(slot)) {
+        throw std::runtime_error("failed to sub-allocate gpu memory!");
+    }
+
+    return allocation;
+}
+
+void GpuAllocator::free(VkDevice device, const GpuAllocation& allocation) {
+    if (allocation.memory == VK_NULL_HANDLE) return;
+
+    std::lock_guard lock(mutex);
+
+    if (allocation.block == GpuAllocation::DEDICATED) {
+        vkFreeMemory(device, allocation.memory, nullptr);
+
+        dedicatedCount--;
+        dedicatedBytes -= allocation.size;
+        return;
+    }
+
+    Block& block = blocks[allocation.block];
+    auto& ranges = block.free;
+
+    // Insert sorted by offset, then merge with the neighbours
+    const auto it = std::ranges::lower_bound(ranges, allocation.offset, {}, &Range::offset);
+
+    // Overlapping a free range means this allocation was freed already
+    assert((it == ranges.end() || allocation.offset + allocation.size <= it->offset) && "GpuAllocator: range freed twice");
+    assert((it == ranges.begin() || (it - 1)->offset + (it - 1)->size <= allocation.offset) && "GpuAllocator: range freed twice");
+    assert(block.allocations > 0 && "GpuAllocator: more frees than allocations in block");
+    auto inserted = ranges.insert(it, {allocation.offset, allocation.size});
+
+    if (const auto next = inserted + 1; next != ranges.end() && inserted->offset + inserted->size == next->offset) {
+        inserted->size += next->size;
+        ranges.erase(next);
+    }
+    if (inserted != ranges.begin()) {
+        if (const auto prev = inserted - 1; prev->offset + prev->size == inserted->offset) {
+            prev->size += inserted->size;
+            ranges.erase(inserted);
+        }
+    }
+
+    // Empty blocks go back to the driver, unless it's the last one of its memory type and kind
+    if (--block.allocations == 0) {
+        const bool another = std::ranges::any_of(blocks, [&](const Block& other) {
+            return &other != &block && other.memory != VK_NULL_HANDLE && other.memoryType == block.memoryType && other.kind == block.kind;
+        });
+
+        if (another) {
+            vkFreeMemory(device, block.memory, nullptr);
+            block = Block{};
+        }
+    }
+}
+
+GpuAllocator::Stats GpuAllocator::stats() {
+    std::lock_guard lock(mutex);
+
+    Stats stats{};
+    stats.dedicated = dedicatedCount;
+    stats.dedicatedBytes = dedicatedBytes;
+
+    for (const Block& block : blocks) {
+        if (block.memory == VK_NULL_HANDLE) continue;
+
+        stats.blocks++;
+        stats.allocations += block.allocations;
+        stats.blockBytes += block.size;
+
+        for (const Range& range : block.free) {
+            stats.freeBytes += range.size;
+            stats.largestFree = std::max(stats.largestFree, range.size);
+            stats.freeRanges++;
+        }
+    }
+
+    stats.usedBytes = stats.blockBytes - stats.freeBytes;
+    return stats;
+}
+
+bool GpuAllocator::supportsResizableBar(VkPhysicalDevice physicalDevice) {
+    constexpr VkDeviceSize BAR_WINDOW = 256ull * 1024 * 1024;
+    constexpr VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    VkPhysicalDeviceMemoryProperties properties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &properties);
+
+    for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
+        const VkMemoryType& type = properties.memoryTypes[i];
+        if ((type.propertyFlags & flags) == flags && properties.memoryHeaps[type.heapIndex].size > BAR_WINDOW) return true;
+    }
+
+    return false;
+}
+
+void GpuAllocator::cleanup(VkDevice device) {
+    std::lock_guard lock(mutex);
+
+    for (Block& block : blocks) {
+        if (block.memory != VK_NULL_HANDLE) vkFreeMemory(device, block.memory, nullptr);
+    }
+
+    blocks.clear();
+    propertiesQueried = false;
+}
+
+VkDeviceMemory GpuAllocator::allocateMemory(VkDevice device, const VkDeviceSize size, const uint32_t memoryType, void** mapped) {
+    // Every block may back buffers that hand out device addresses
+    VkMemoryAllocateFlagsInfo allocFlagsInfo{};
+    allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+    allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryType;
+    allocInfo.pNext = &allocFlagsInfo;
+
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate gpu memory block!");
+    }
+
+    *mapped = nullptr;
+    if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped);
+    }
+
+    return memory;
+}
+
+bool GpuAllocator::suballocate(Block& block, const VkMemoryRequirements& requirements, VkDeviceSize& offset) {
+    for (auto it = block.free.begin(); it != block.free.end(); ++it) {
+        const VkDeviceSize aligned = (it->offset + requirements.alignment - 1) / requirements.alignment * requirements.alignment;
+        const VkDeviceSize padding = aligned - it->offset;
+        if (it->size < padding + requirements.size) continue;
+
+        offset = aligned;
+
+        // Alignment padding stays a free range of its own so it can be coalesced later
+        const Range tail{aligned + requirements.size, it->size - padding - requirements.size};
+        if (padding > 0) {
+            it->size = padding;
+            if (tail.size > 0) block.free.insert(it + 1, tail);
+        } else if (tail.size > 0) {
+            *it = tail;
+        } else {
+            block.free.erase(it);
+        }
+
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,102 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_GPUALLOCATOR_H
+#define INC_2G43S_GPUALLOCATOR_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+
+// Piece of a memory block (or a dedicated allocation), bind resources at memory + offset
+struct GpuAllocation {
+    static constexpr uint32_t DEDICATED = UINT32_MAX;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr; // Host visible memory stays mapped for its whole life, already offset
+
+    uint32_t memoryType = UINT32_MAX;
+    uint32_t block = DEDICATED;
+};
+
+// Buffers and linear images never share a block with optimal images, so bufferImageGranularity can be ignored
+enum class GpuResourceKind : uint8_t {
+    Linear,
+    Optimal
+};
+
+// Large blocks per memory type, sub-allocated with first fit over an offset sorted free list that coalesces on free
+struct GpuAllocator {
+    static constexpr VkDeviceSize BLOCK_SIZE = 64ull * 1024 * 1024;
+    static constexpr VkDeviceSize DEDICATED_THRESHOLD = BLOCK_SIZE / 2; // Bigger requests get their own vkAllocateMemory
+
+    struct Stats {
+        uint32_t blocks = 0;
+        uint32_t dedicated = 0;
+        uint32_t allocations = 0; // Live sub-allocations
+        VkDeviceSize blockBytes = 0;
+        VkDeviceSize dedicatedBytes = 0;
+        VkDeviceSize usedBytes = 0;
+        VkDeviceSize freeBytes = 0;
+        VkDeviceSize largestFree = 0;
+        uint32_t freeRanges = 0;
+
+        // 0 when all free space is one range, close to 1 when it's scattered into small holes
+        [[nodiscard]] double fragmentation() const {
+            return freeBytes == 0 ? 0.0 : 1.0 - static_cast<double>(largestFree) / static_cast<double>(freeBytes);
+        }
+    };
+
+    static GpuAllocation allocate(
+        VkDevice device, VkPhysicalDevice physicalDevice,
+        const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, GpuResourceKind kind
+        );
+
+    static void free(VkDevice device, const GpuAllocation& allocation);
+
+    static Stats stats();
+
+    // Large device local heap the host can write directly (resizable BAR / SAM), not just the 256 MB window
+    static bool supportsResizableBar(VkPhysicalDevice physicalDevice);
+
+    // Releases every block, all resources have to be destroyed before
+    static void cleanup(VkDevice device);
+
+private:
+    struct Range {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+    };
+
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        void* mapped = nullptr;
+
+        uint32_t memoryType = 0;
+        GpuResourceKind kind = GpuResourceKind::Linear;
+
+        std::vector<Range> free{};
+        uint32_t allocations = 0;
+    };
+
+    static VkDeviceMemory allocateMemory(VkDevice device, VkDeviceSize size, uint32_t memoryType, void** mapped);
+
+    static bool suballocate(Block& block, const VkMemoryRequirements& requirements, VkDeviceSize& offset);
+
+    inline static std::mutex mutex{};
+    inline static std::vector<Block> blocks{};
+    inline static VkPhysicalDeviceMemoryProperties memoryProperties{};
+    inline static bool propertiesQueried = false;
+
+    inline static uint32_t dedicatedCount = 0;
+    inline static VkDeviceSize dedicatedBytes = 0;
+};
+
+
+#endif //INC_2G43S_GPUALLOCATOR_H
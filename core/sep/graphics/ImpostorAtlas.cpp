@@ -0,0 +1,191 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#include "ImpostorAtlas.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Barrier.h"
+#include "BuffersRegistry.hpp"
+#include "Images.hpp"
+#include "ModelEntityManager.hpp"
+#include "Types.hpp"
+#include "glmMath.h"
+#include "VertexPushConstants.hpp"
+
+// Cameras are read through buffer references, which want them 16 byte aligned
+static constexpr VkDeviceSize CAMERA_STRIDE = (sizeof(UniformBuffer) + 15) & ~VkDeviceSize{15};
+static constexpr VkDeviceSize CAMERAS_OFFSET = 128;
+
+
+void ImpostorAtlas::create(
+    VkDevice device, VkPhysicalDevice physicalDevice,
+    const ModelEntityManager& models, const std::vector<VkDrawIndexedIndirectCommand>& drawCommands,
+    const VkFormat colorFormat, const VkFormat depthFormat
+    ) {
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    rows = static_cast<uint32_t>(std::min<size_t>({drawCommands.size(), models.regions.size(), properties.limits.maxImageDimension2D / TILE_SIZE}));
+
+    commands.resize(rows);
+    for (uint32_t i = 0; i < rows; ++i) {
+        commands[i] = drawCommands[i];
+        commands[i].instanceCount = 1;
+        commands[i].firstInstance = 0;
+    }
+
+    // Never empty, the texture array needs a view either way
+    const uint32_t width = VIEWS * TILE_SIZE;
+    const uint32_t height = std::max(rows, 1u) * TILE_SIZE;
+
+    Images::createImage(device, physicalDevice, width, height, colorFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+    view = Images::createImageView(device, image, colorFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+
+    Images::createImage(device, physicalDevice, width, height, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthMemory);
+    depthView = Images::createImageView(device, depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+    void* mapped = nullptr;
+    BuffersRegistry::createGenericBuffer(
+        device, physicalDevice, bakeConstant, bakeBuffer, bakeMemory, mapped,
+        CAMERAS_OFFSET + CAMERA_STRIDE * VIEWS * std::max(rows, 1u),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+
+    auto* bytes = static_cast<char*>(mapped);
+    const glm::mat4 identity(1.0f);
+    constexpr uint32_t visibleIndex = 0;
+    memcpy(bytes, &identity, sizeof(identity));
+    memcpy(bytes + sizeof(identity), &visibleIndex, sizeof(visibleIndex));
+
+    for (uint32_t row = 0; row < rows; ++row) {
+        const glm::vec4 sphere = models.groups[models.regions[row].modelIndex].model->sphere;
+        const glm::vec3 center(sphere);
+        const float radius = std::max(sphere.w, 0.001f);
+
+        for (uint32_t column = 0; column < VIEWS; ++column) {
+            const float azimuth = glm::two_pi<float>() * static_cast<float>(column) / static_cast<float>(VIEWS);
+            const glm::vec3 direction(std::cos(azimuth), std::sin(azimuth), 0.0f);
+
+            UniformBuffer camera{};
+            camera.view = glm::lookAt(center + direction * radius * 2.0f, center, glm::vec3(0.0f, 0.0f, 1.0f)); // z-up
+            camera.proj = glm::ortho(-radius, radius, -radius, radius, radius, radius * 3.0f);
+            camera.proj[1][1] *= -1;
+
+            memcpy(bytes + cameraOffset(row, column), &camera, sizeof(camera));
+        }
+    }
+
+    baked = false;
+}
+
+void ImpostorAtlas::record(
+    VkCommandBuffer commandBuffer,
+    VkPipeline pipeline, VkPipelineLayout pipelineLayout, VkDescriptorSet descriptorSet,
+    VkBuffer vertexBuffer, VkBuffer indexBuffer, const uint64_t materials
+    ) {
+
+    Barrier toAttachment(commandBuffer);
+    toAttachment.image(
+        image,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        VK_ACCESS_2_NONE, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    ).image(
+        depthImage,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        VK_ACCESS_2_NONE, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT,
+        VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT
+    ).apply();
+
+    const VkExtent2D extent{VIEWS * TILE_SIZE, std::max(rows, 1u) * TILE_SIZE};
+
+    // Transparent where nothing was drawn, the impostor shader discards those texels
+    VkRenderingAttachmentInfo colorAttachment{};
+    colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    colorAttachment.imageView = view;
+    colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.clearValue.color = {{0.0f, 0.0f, 0.0f, 0.0f}};
+
+    VkRenderingAttachmentInfo depthAttachment{};
+    depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    depthAttachment.imageView = depthView;
+    depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.clearValue.depthStencil = {1.0f, 0};
+
+    VkRenderingInfo renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+    renderingInfo.renderArea = {{0, 0}, extent};
+    renderingInfo.layerCount = 1;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachments = &colorAttachment;
+    renderingInfo.pDepthAttachment = &depthAttachment;
+
+    vkCmdBeginRendering(commandBuffer, &renderingInfo);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+    VertexPushConstants constants{};
+    constants.mb = bakeConstant;
+    constants.vib = bakeConstant + sizeof(glm::mat4);
+    constants.materials = materials;
+
+    for (uint32_t row = 0; row < rows; ++row) {
+        const VkDrawIndexedIndirectCommand& command = commands[row];
+
+        for (uint32_t column = 0; column < VIEWS; ++column) {
+            const VkViewport viewport{static_cast<float>(column * TILE_SIZE), static_cast<float>(row * TILE_SIZE), static_cast<float>(TILE_SIZE), static_cast<float>(TILE_SIZE), 0.0f, 1.0f};
+            const VkRect2D scissor{{static_cast<int32_t>(column * TILE_SIZE), static_cast<int32_t>(row * TILE_SIZE)}, {TILE_SIZE, TILE_SIZE}};
+            vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+            constants.ubo = bakeConstant + cameraOffset(row, column);
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(VertexPushConstants), &constants);
+
+            vkCmdDrawIndexed(commandBuffer, command.indexCount, 1, command.firstIndex, static_cast<int32_t>(command.vertexOffset), 0);
+        }
+    }
+
+    vkCmdEndRendering(commandBuffer);
+
+    Barrier toSampled(commandBuffer);
+    toSampled.image(
+        image,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_2_SHADER_READ_BIT,
+        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    ).apply();
+
+    baked = true;
+}
+
+void ImpostorAtlas::cleanup(VkDevice device) const {
+    if (image == VK_NULL_HANDLE) return;
+
+    vkDestroyImageView(device, view, nullptr);
+    Images::destroyImage(device, image, memory);
+    vkDestroyImageView(device, depthView, nullptr);
+    Images::destroyImage(device, depthImage, depthMemory);
+    BuffersRegistry::destroyBuffer(device, bakeBuffer, bakeMemory);
+}
+
+VkDeviceSize ImpostorAtlas::cameraOffset(const uint32_t row, const uint32_t column) const {
+    return CAMERAS_OFFSET + CAMERA_STRIDE * (row * VIEWS + column);
+}
@@ -0,0 +1,61 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_IMPOSTORATLAS_H
+#define INC_2G43S_IMPOSTORATLAS_H
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "GpuAllocator.hpp"
+
+struct ModelEntityManager;
+
+// Pre-rendered views of every draw command for far band impostors. Row r holds command r, column v the view
+// from azimuth 2pi * v / VIEWS around the model's z axis, framed on its bounding sphere
+struct ImpostorAtlas {
+    static constexpr uint32_t VIEWS = 8;
+    static constexpr uint32_t TILE_SIZE = 64;
+
+    VkImage image{};
+    GpuAllocation memory{};
+    VkImageView view{};
+
+    VkImage depthImage{};
+    GpuAllocation depthMemory{};
+    VkImageView depthView{};
+
+    // Identity model matrix, visible index 0, then one camera per tile
+    VkBuffer bakeBuffer{};
+    GpuAllocation bakeMemory{};
+    uint64_t bakeConstant{};
+
+    std::vector<VkDrawIndexedIndirectCommand> commands{}; // Single instance of every baked row
+    uint32_t rows = 0;
+    uint32_t slot = 0; // Index in the scene's texture array
+    bool baked = false;
+
+    // Rows for the commands existing now, later ones stay meshes at any distance
+    void create(
+        VkDevice device, VkPhysicalDevice physicalDevice,
+        const ModelEntityManager& models, const std::vector<VkDrawIndexedIndirectCommand>& drawCommands,
+        VkFormat colorFormat, VkFormat depthFormat
+        );
+
+    // Draws every tile with the scene pipeline, the atlas is readable by fragment shaders once this is recorded
+    void record(
+        VkCommandBuffer commandBuffer,
+        VkPipeline pipeline, VkPipelineLayout pipelineLayout, VkDescriptorSet descriptorSet,
+        VkBuffer vertexBuffer, VkBuffer indexBuffer, uint64_t materials
+        );
+
+    void cleanup(VkDevice device) const;
+
+private:
+    VkDeviceSize cameraOffset(uint32_t row, uint32_t column) const;
+};
+
+
+#endif //INC_2G43S_IMPOSTORATLAS_H
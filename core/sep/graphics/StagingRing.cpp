@@ -0,0 +1,99 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#include "StagingRing.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "BuffersRegistry.hpp"
+
+
+void StagingRing::initialize(VkDevice device, VkPhysicalDevice physicalDevice, const size_t slotCount) {
+    this->device = device;
+    this->physicalDevice = physicalDevice;
+
+    slots.resize(slotCount);
+    for (Slot& slot : slots) {
+        growSlot(slot, INITIAL_SIZE);
+    }
+
+    current = 0;
+    uploads.clear();
+}
+
+VkDeviceSize StagingRing::stage(const void* data, const VkDeviceSize size) {
+    Slot& slot = slots[current];
+
+    const VkDeviceSize offset = (slot.head + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (offset + size > slot.size) growSlot(slot, std::max(slot.size * 2, offset + size));
+
+    memcpy(static_cast<char*>(slot.memory.mapped) + offset, data, size);
+    slot.head = offset + size;
+    peakBytes = std::max(peakBytes, slot.head);
+
+    return offset;
+}
+
+void StagingRing::copy(VkBuffer dst, const VkDeviceSize dstOffset, const VkDeviceSize srcOffset, const VkDeviceSize size) {
+    uploads.emplace_back(dst, VkBufferCopy{srcOffset, dstOffset, size});
+}
+
+void StagingRing::upload(VkBuffer dst, const VkDeviceSize dstOffset, const void* data, const VkDeviceSize size) {
+    copy(dst, dstOffset, stage(data, size), size);
+}
+
+void StagingRing::retarget(VkBuffer from, VkBuffer to) {
+    for (Upload& upload : uploads) {
+        if (upload.dst == from) upload.dst = to;
+    }
+}
+
+void StagingRing::record(VkCommandBuffer commandBuffer) {
+    Slot& slot = slots[current];
+
+    if (!uploads.empty()) {
+        // Stable, later writes to the same bytes have to land last
+        std::ranges::stable_sort(uploads, {}, [](const Upload& upload) { return upload.dst; });
+
+        std::vector<VkBufferCopy> regions{};
+        for (size_t i = 0; i < uploads.size();) {
+            const VkBuffer dst = uploads[i].dst;
+
+            regions.clear();
+            for (; i < uploads.size() && uploads[i].dst == dst; ++i) {
+                regions.emplace_back(uploads[i].region);
+            }
+
+            vkCmdCopyBuffer(commandBuffer, slot.buffer, dst, static_cast<uint32_t>(regions.size()), regions.data());
+        }
+
+        uploads.clear();
+    }
+
+    current = (current + 1) % slots.size();
+    slots[current].head = 0;
+}
+
+void StagingRing::cleanup() const {
+    for (const Slot& slot : slots) {
+        BuffersRegistry::destroyBuffer(device, slot.buffer, slot.memory);
+    }
+}
+
+void StagingRing::growSlot(Slot& slot, const VkDeviceSize required) const {
+    VkBuffer buffer{};
+    GpuAllocation memory{};
+    BuffersRegistry::createBuffer(device, physicalDevice, required, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer, memory);
+
+    // The slot being filled isn't read by the gpu yet, so the old buffer can go right away
+    if (slot.buffer != VK_NULL_HANDLE) {
+        memcpy(memory.mapped, slot.memory.mapped, slot.head);
+        BuffersRegistry::destroyBuffer(device, slot.buffer, slot.memory);
+    }
+
+    slot.buffer = buffer;
+    slot.memory = memory;
+    slot.size = required;
+}
@@ -0,0 +1,65 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_STAGINGRING_H
+#define INC_2G43S_STAGINGRING_H
+
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "GpuAllocator.hpp"
+
+// Persistent host visible buffers, one per frame slot, that carry host writes into device local buffers.
+// Data staged between two frames is copied at the start of the next recorded command buffer.
+// Needs MAX_FRAMES_IN_FLIGHT + 1 slots: writes for the next frame start before its slot is waited on the frame
+// timeline, so the slot being filled must belong to a frame that is already known to be finished. Not thread safe, callers lock
+struct StagingRing {
+    static constexpr VkDeviceSize INITIAL_SIZE = 4ull * 1024 * 1024;
+    static constexpr VkDeviceSize ALIGNMENT = 16;
+
+    struct Upload {
+        VkBuffer dst{};
+        VkBufferCopy region{};
+    };
+
+    struct Slot {
+        VkBuffer buffer{};
+        GpuAllocation memory{};
+        VkDeviceSize size = 0;
+        VkDeviceSize head = 0;
+    };
+
+    VkDevice device{};
+    VkPhysicalDevice physicalDevice{};
+
+    std::vector<Slot> slots{};
+    uint32_t current = 0;
+    std::vector<Upload> uploads{}; // Of the current slot
+
+    VkDeviceSize peakBytes = 0;
+
+    void initialize(VkDevice device, VkPhysicalDevice physicalDevice, size_t slotCount);
+
+    // Copies data into the current slot and returns its offset there, grows the slot when it's full
+    VkDeviceSize stage(const void* data, VkDeviceSize size);
+
+    // Queues a copy of previously staged bytes, one staged block can feed several buffers
+    void copy(VkBuffer dst, VkDeviceSize dstOffset, VkDeviceSize srcOffset, VkDeviceSize size);
+
+    void upload(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+
+    // Queued copies into from are redirected to its replacement
+    void retarget(VkBuffer from, VkBuffer to);
+
+    // Records the queued copies grouped per destination and moves on to the next slot, once per recorded frame
+    void record(VkCommandBuffer commandBuffer);
+
+    void cleanup() const;
+
+private:
+    void growSlot(Slot& slot, VkDeviceSize required) const;
+};
+
+
+#endif //INC_2G43S_STAGINGRING_H
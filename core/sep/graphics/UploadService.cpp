@@ -0,0 +1,287 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#include "UploadService.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "BuffersRegistry.hpp"
+#include "Logger.hpp"
+#include "Queue.hpp"
+#include "Sync.hpp"
+
+
+static void pipelineBarrier(VkCommandBuffer commandBuffer, const std::vector<VkBufferMemoryBarrier2>& buffers, const std::vector<VkImageMemoryBarrier2>& images) {
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.pBufferMemoryBarriers = buffers.data();
+    dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(buffers.size());
+    dependencyInfo.pImageMemoryBarriers = images.data();
+    dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(images.size());
+
+    vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+static VkImageMemoryBarrier2 imageBarrier(VkImage image, const VkImageLayout oldLayout, const VkImageLayout newLayout) {
+    VkImageMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.image = image;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+
+    return barrier;
+}
+
+void UploadService::initialize(VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) {
+    Logger LOGGER{"UploadService"};
+
+    this->device = device;
+    this->physicalDevice = physicalDevice;
+
+    const QueueFamilyIndices indices = Queue::findQueueFamilies(physicalDevice, surface);
+    graphicsFamily = indices.graphicsFamily.value();
+    transferFamily = indices.transferFamily.value_or(graphicsFamily);
+    vkGetDeviceQueue(device, transferFamily, 0, &transferQueue);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = transferFamily;
+
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload command pool!");
+    }
+
+    Sync::createTimelineSemaphore(device, timeline);
+
+    LOGGER.info("Uploads go to queue family ${}, dedicated: ${}", transferFamily, dedicated());
+}
+
+UploadService::Staging UploadService::stage(const VkDeviceSize size) const {
+    Staging staging{};
+    BuffersRegistry::createBuffer(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging.buffer, staging.memory);
+    staging.mapped = staging.memory.mapped;
+
+    return staging;
+}
+
+UploadService::Ticket UploadService::copy(const Staging& staging, VkBuffer dst, const VkDeviceSize dstOffset, const VkDeviceSize size) {
+    std::lock_guard lock(mutex);
+
+    const VkCommandBuffer commandBuffer = begin();
+    open.staging.emplace_back(staging);
+
+    VkBufferCopy region{};
+    region.dstOffset = dstOffset;
+    region.size = size;
+    vkCmdCopyBuffer(commandBuffer, staging.buffer, dst, 1, &region);
+
+    // Same family needs nothing more, the timeline wait makes the copy visible
+    if (dedicated()) {
+        VkBufferMemoryBarrier2 release{};
+        release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+        release.buffer = dst;
+        release.offset = dstOffset;
+        release.size = size;
+        release.srcQueueFamilyIndex = transferFamily;
+        release.dstQueueFamilyIndex = graphicsFamily;
+        release.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+        release.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+        VkBufferMemoryBarrier2 acquire = release;
+        acquire.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+        acquire.srcAccessMask = VK_ACCESS_2_NONE;
+        acquire.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        acquire.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+
+        pipelineBarrier(commandBuffer, {release}, {});
+        openAcquire.buffers.emplace_back(acquire);
+    }
+
+    return open.ticket;
+}
+
+UploadService::Ticket UploadService::copy(const Staging& staging, VkImage image, const uint32_t width, const uint32_t height) {
+    std::lock_guard lock(mutex);
+
+    const VkCommandBuffer commandBuffer = begin();
+    open.staging.emplace_back(staging);
+
+    VkImageMemoryBarrier2 transferDst = imageBarrier(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    transferDst.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    transferDst.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    pipelineBarrier(commandBuffer, {}, {transferDst});
+
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {width, height, 1};
+    vkCmdCopyBufferToImage(commandBuffer, staging.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    // With a dedicated family this is the release half, the layout transition happens once for the pair
+    VkImageMemoryBarrier2 shaderRead = imageBarrier(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    shaderRead.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    shaderRead.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+    if (dedicated()) {
+        shaderRead.srcQueueFamilyIndex = transferFamily;
+        shaderRead.dstQueueFamilyIndex = graphicsFamily;
+
+        VkImageMemoryBarrier2 acquire = shaderRead;
+        acquire.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+        acquire.srcAccessMask = VK_ACCESS_2_NONE;
+        acquire.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        acquire.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+        openAcquire.images.emplace_back(acquire);
+    }
+
+    pipelineBarrier(commandBuffer, {}, {shaderRead});
+
+    return open.ticket;
+}
+
+UploadService::Ticket UploadService::upload(VkBuffer dst, const VkDeviceSize dstOffset, const void* data, const VkDeviceSize size) {
+    const Staging staging = stage(size);
+    memcpy(staging.mapped, data, size);
+
+    return copy(staging, dst, dstOffset, size);
+}
+
+UploadService::Ticket UploadService::upload(VkImage image, const uint32_t width, const uint32_t height, const void* data, const VkDeviceSize size) {
+    const Staging staging = stage(size);
+    memcpy(staging.mapped, data, size);
+
+    return copy(staging, image, width, height);
+}
+
+UploadService::Ticket UploadService::flush() {
+    std::lock_guard lock(mutex);
+
+    if (open.commandBuffer == VK_NULL_HANDLE) return nextTicket - 1;
+
+    if (vkEndCommandBuffer(open.commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record upload batch!");
+    }
+
+    VkCommandBufferSubmitInfo commandBufferInfo{};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+    commandBufferInfo.commandBuffer = open.commandBuffer;
+
+    VkSemaphoreSubmitInfo signalInfo{};
+    signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    signalInfo.semaphore = timeline;
+    signalInfo.value = open.ticket;
+    signalInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    VkSubmitInfo2 submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+    submitInfo.commandBufferInfoCount = 1;
+    submitInfo.pCommandBufferInfos = &commandBufferInfo;
+    submitInfo.signalSemaphoreInfoCount = 1;
+    submitInfo.pSignalSemaphoreInfos = &signalInfo;
+
+    if (vkQueueSubmit2(transferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit upload batch!");
+    }
+
+    pendingAcquire.buffers.insert(pendingAcquire.buffers.end(), openAcquire.buffers.begin(), openAcquire.buffers.end());
+    pendingAcquire.images.insert(pendingAcquire.images.end(), openAcquire.images.begin(), openAcquire.images.end());
+    openAcquire = Acquire{};
+
+    submitted.emplace_back(std::move(open));
+    open = Batch{};
+
+    return nextTicket++;
+}
+
+bool UploadService::completed(const Ticket ticket) const {
+    return Sync::timelineValue(device, timeline) >= ticket;
+}
+
+void UploadService::wait(const Ticket ticket) {
+    bool unsubmitted;
+    {
+        std::lock_guard lock(mutex);
+        unsubmitted = ticket >= nextTicket;
+    }
+    if (unsubmitted) flush();
+
+    Sync::waitTimeline(device, timeline, ticket);
+}
+
+UploadService::Ticket UploadService::acquire(VkCommandBuffer commandBuffer) {
+    std::lock_guard lock(mutex);
+
+    const Ticket ticket = nextTicket - 1;
+    if (ticket == acquiredTicket) return 0;
+
+    if (!pendingAcquire.buffers.empty() || !pendingAcquire.images.empty()) {
+        pipelineBarrier(commandBuffer, pendingAcquire.buffers, pendingAcquire.images);
+        pendingAcquire = Acquire{};
+    }
+
+    acquiredTicket = ticket;
+    return ticket;
+}
+
+void UploadService::collect() {
+    std::lock_guard lock(mutex);
+
+    if (submitted.empty()) return;
+
+    const uint64_t value = Sync::timelineValue(device, timeline);
+
+    std::erase_if(submitted, [&](const Batch& batch) {
+        if (batch.ticket > value) return false;
+
+        for (const Staging& staging : batch.staging) {
+            BuffersRegistry::destroyBuffer(device, staging.buffer, staging.memory);
+        }
+        vkFreeCommandBuffers(device, commandPool, 1, &batch.commandBuffer);
+        return true;
+    });
+}
+
+void UploadService::cleanup() const {
+    for (const Batch& batch : submitted) {
+        for (const Staging& staging : batch.staging) {
+            BuffersRegistry::destroyBuffer(device, staging.buffer, staging.memory);
+        }
+    }
+    for (const Staging& staging : open.staging) {
+        BuffersRegistry::destroyBuffer(device, staging.buffer, staging.memory);
+    }
+
+    vkDestroyCommandPool(device, commandPool, nullptr);
+    vkDestroySemaphore(device, timeline, nullptr);
+}
+
+VkCommandBuffer UploadService::begin() {
+    if (open.commandBuffer != VK_NULL_HANDLE) return open.commandBuffer;
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = commandPool;
+    allocInfo.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(device, &allocInfo, &open.commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate upload command buffer!");
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(open.commandBuffer, &beginInfo);
+
+    open.ticket = nextTicket;
+    return open.commandBuffer;
+}
@@ -0,0 +1,103 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_UPLOADSERVICE_H
+#define INC_2G43S_UPLOADSERVICE_H
+
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "GpuAllocator.hpp"
+
+// Uploads into device local buffers and images on the transfer queue, the graphics one when there is no separate
+// transfer family. Requests are recorded into one open batch, flush() submits it and signals the next value of a
+// timeline semaphore. That value is the request's ticket, consumers wait for exactly the upload they need
+struct UploadService {
+    using Ticket = uint64_t;
+
+    // Host visible scratch for one request, owned by the batch it gets copied in
+    struct Staging {
+        VkBuffer buffer{};
+        GpuAllocation memory{};
+        void* mapped = nullptr;
+    };
+
+    VkDevice device{};
+    VkPhysicalDevice physicalDevice{};
+
+    VkQueue transferQueue{};
+    uint32_t transferFamily = 0;
+    uint32_t graphicsFamily = 0;
+
+    VkCommandPool commandPool{};
+    VkSemaphore timeline{};
+
+    void initialize(VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
+
+    [[nodiscard]] bool dedicated() const {
+        return transferFamily != graphicsFamily;
+    }
+
+    // Every staged block has to go through exactly one copy, the data can be written until then.
+    // Destinations are handed over to the graphics queue afterwards, so each one is written once, live data goes
+    // through BufferManager's staging ring instead
+    [[nodiscard]] Staging stage(VkDeviceSize size) const;
+
+    Ticket copy(const Staging& staging, VkBuffer dst, VkDeviceSize dstOffset, VkDeviceSize size);
+
+    // Whole first mip and layer, the image ends up in SHADER_READ_ONLY_OPTIMAL
+    Ticket copy(const Staging& staging, VkImage image, uint32_t width, uint32_t height);
+
+    Ticket upload(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+
+    Ticket upload(VkImage image, uint32_t width, uint32_t height, const void* data, VkDeviceSize size);
+
+    // Submits the open batch, returns the newest submitted ticket.
+    // The transfer queue may be the graphics queue, so only call it from the thread that submits frames
+    Ticket flush();
+
+    [[nodiscard]] bool completed(Ticket ticket) const;
+
+    // Host wait for one ticket, flushes first if it is still in the open batch
+    void wait(Ticket ticket);
+
+    // Records the graphics side of the ownership transfers for everything submitted since the last call.
+    // Returns the timeline value the command buffer's submit has to wait for, 0 when there is nothing new
+    Ticket acquire(VkCommandBuffer commandBuffer);
+
+    // Frees staging and command buffers of finished batches
+    void collect();
+
+    void cleanup() const;
+
+private:
+    struct Batch {
+        VkCommandBuffer commandBuffer{};
+        Ticket ticket = 0;
+        std::vector<Staging> staging{};
+    };
+
+    // Graphics queue halves of the release barriers, valid once their batch is submitted
+    struct Acquire {
+        std::vector<VkBufferMemoryBarrier2> buffers{};
+        std::vector<VkImageMemoryBarrier2> images{};
+    };
+
+    Batch open{};
+    std::vector<Batch> submitted{};
+    Acquire openAcquire{};
+    Acquire pendingAcquire{};
+
+    Ticket nextTicket = 1; // Signalled by the open batch
+    Ticket acquiredTicket = 0;
+
+    // Requests come from loading and streaming threads, submits from the render thread
+    static inline std::mutex mutex{};
+
+    VkCommandBuffer begin();
+};
+
+
+#endif //INC_2G43S_UPLOADSERVICE_H
@@ -8,10 +8,10 @@
 #include "Images.hpp"
 
 
-void Helper::createDepthResources(const VkDevice& device, const VkPhysicalDevice& physicalDevice, VkImage& depthImage, VkDeviceMemory& depthImageMemory, VkImageView& depthImageView, const VkExtent2D& swapchainExtent) {
+void Helper::createDepthResources(const VkDevice& device, const VkPhysicalDevice& physicalDevice, VkImage& depthImage, GpuAllocation& depthImageMemory, VkImageView& depthImageView, const VkExtent2D& swapchainExtent) {
     const VkFormat depthFormat = findDepthFormat(physicalDevice);
 
-    Images::createImage(device, physicalDevice, swapchainExtent.width, swapchainExtent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory);
+    Images::createImage(device, physicalDevice, swapchainExtent.width, swapchainExtent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory);
     depthImageView = Images::createImageView(device, depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
 
     //transitionImageLayout(device, commandPool, graphicsQueue, depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
@@ -8,9 +8,11 @@
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
+#include "GpuAllocator.hpp"
+
 
 struct Helper {
-    static void createDepthResources(const VkDevice& device, const VkPhysicalDevice& physicalDevice, VkImage& depthImage, VkDeviceMemory& depthImageMemory, VkImageView& depthImageView, const VkExtent2D& swapchainExtent);
+    static void createDepthResources(const VkDevice& device, const VkPhysicalDevice& physicalDevice, VkImage& depthImage, GpuAllocation& depthImageMemory, VkImageView& depthImageView, const VkExtent2D& swapchainExtent);
 
     // Choosing suitable memory type
     static uint32_t findMemoryType( const uint32_t& typeFilter, VkMemoryPropertyFlags properties, const VkPhysicalDevice& physicalDevice);
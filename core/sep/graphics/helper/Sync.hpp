@@ -40,6 +40,42 @@ static void createSemaphores(VkDevice& device, const size_t MAX_FRAMES_IN_FLIGHT
             }
         }(pack), ...);
     }
+
+    static void createTimelineSemaphore(VkDevice device, VkSemaphore& semaphore, const uint64_t initialValue = 0) {
+        VkSemaphoreTypeCreateInfo typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = initialValue;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create timeline semaphore!");
+        }
+    }
+
+    static uint64_t timelineValue(VkDevice device, VkSemaphore semaphore) {
+        uint64_t value = 0;
+        vkGetSemaphoreCounterValue(device, semaphore, &value);
+        return value;
+    }
+
+    // Blocks only while the gpu is still behind value
+    static void waitTimeline(VkDevice device, VkSemaphore semaphore, const uint64_t value) {
+        if (value == 0 || timelineValue(device, semaphore) >= value) return;
+
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &semaphore;
+        waitInfo.pValues = &value;
+
+        if (vkWaitSemaphores(device, &waitInfo, UINT64_MAX) != VK_SUCCESS) {
+            throw std::runtime_error("failed to wait for timeline semaphore!");
+        }
+    }
 };
 
 #endif //INC_2G43S_SYNC_H
\ No newline at end of file
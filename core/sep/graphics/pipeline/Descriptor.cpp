@@ -57,7 +57,7 @@ void Descriptor::createGraphicsDescriptorPool(
 void Descriptor::createGraphicsDescriptorSets(
         VkDevice device,
         VkDescriptorSetLayout& graphicsDescriptorSetLayout, VkDescriptorPool& graphicsDescriptorPool, std::vector<VkDescriptorSet>& graphicsDescriptorSets,
-        VkSampler textureSampler, VkImageView textureImageView,
+        VkSampler textureSampler, VkImageView textureImageView, VkImageView impostorImageView,
         const ModelEntityManager &modelEntityManager, size_t MAX_FRAMES_IN_FLIGHT
         ) {
 
@@ -100,6 +100,14 @@ void Descriptor::createGraphicsDescriptorSets(
             }
         }
 
+        // Impostor atlas goes last, after every model texture
+        VkDescriptorImageInfo impostors{};
+        impostors.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        impostors.imageView = impostorImageView;
+        impostors.sampler = textureSampler;
+
+        imageInfo.emplace_back(impostors);
+
         VkWriteDescriptorSet descriptorWrite{};
 
         descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
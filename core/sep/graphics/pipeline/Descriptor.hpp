@@ -26,7 +26,7 @@ struct Descriptor {
     static void createGraphicsDescriptorSets(
         VkDevice device,
         VkDescriptorSetLayout& graphicsDescriptorSetLayout, VkDescriptorPool& graphicsDescriptorPool, std::vector<VkDescriptorSet>& graphicsDescriptorSets,
-        VkSampler textureSampler, VkImageView textureImageView,
+        VkSampler textureSampler, VkImageView textureImageView, VkImageView impostorImageView,
         const ModelEntityManager &modelEntityManager, size_t MAX_FRAMES_IN_FLIGHT
         );
 
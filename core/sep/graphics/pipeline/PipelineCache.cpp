@@ -0,0 +1,84 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#include "PipelineCache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "Logger.hpp"
+#include "Tools.hpp"
+
+
+void PipelineCache::load(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& path) {
+    this->path = path;
+
+    std::vector<char> data{};
+    if (std::filesystem::exists(path)) {
+        data = Tools::readFile(path.c_str());
+
+        if (!matches(data, physicalDevice)) {
+            Logger LOGGER{"PipelineCache"};
+            LOGGER.warn("Pipeline cache is from another device or driver, starting empty");
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+}
+
+void PipelineCache::save(VkDevice device) const {
+    if (cache == VK_NULL_HANDLE) return;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size == 0) return;
+
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS) return;
+
+    Logger LOGGER{"PipelineCache"};
+
+    // Written aside and renamed, a crash mid write never leaves a torn cache behind
+    const std::string temporary = path + ".tmp";
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        LOGGER.error("Failed to open pipeline cache for writing: ${}", temporary);
+        return;
+    }
+
+    file.write(data.data(), static_cast<std::streamsize>(size));
+    file.close();
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) LOGGER.error("Failed to save pipeline cache: ${}", error.message());
+}
+
+void PipelineCache::cleanup(VkDevice device) const {
+    vkDestroyPipelineCache(device, cache, nullptr);
+}
+
+bool PipelineCache::matches(const std::vector<char>& data, VkPhysicalDevice physicalDevice) {
+    VkPipelineCacheHeaderVersionOne header{};
+    if (data.size() < sizeof(header)) return false;
+    memcpy(&header, data.data(), sizeof(header));
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    return header.headerSize >= sizeof(header)
+        && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == properties.vendorID
+        && header.deviceID == properties.deviceID
+        && memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
@@ -0,0 +1,31 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_PIPELINECACHE_H
+#define INC_2G43S_PIPELINECACHE_H
+
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+// Driver pipeline cache kept on disk between runs. A file written by another device or driver is ignored
+// and overwritten on the next save
+struct PipelineCache {
+    VkPipelineCache cache{};
+    std::string path{};
+
+    void load(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& path);
+
+    // Whatever the driver compiled since load, through the whole run
+    void save(VkDevice device) const;
+
+    void cleanup(VkDevice device) const;
+
+private:
+    // Header as laid out by VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+    static bool matches(const std::vector<char>& data, VkPhysicalDevice physicalDevice);
+};
+
+
+#endif //INC_2G43S_PIPELINECACHE_H
@@ -6,17 +6,23 @@
 
 #include <stdexcept>
 
+#include "../shaders/ShaderArchive.hpp"
 #include "../shaders/Shaders.hpp"
 #include "Helper.hpp"
+#include "ShaderSpecialization.hpp"
 #include "Tools.hpp"
 #include "Vertex.hpp"
+#include "shaders/constants/CompactPushConstants.hpp"
 #include "shaders/constants/CullingPushConstants.hpp"
+#include "shaders/constants/DepthPyramidPushConstants.hpp"
+#include "shaders/constants/ImpostorPushConstants.hpp"
 #include "shaders/constants/MatrixPushConstants.hpp"
 #include "shaders/constants/PostprocessPushConstants.hpp"
+#include "shaders/constants/VertexPushConstants.hpp"
 
-void PipelineCreation::createGraphicsPipeline(VkDevice& device, VkPhysicalDevice& physicalDevice, VkPipelineLayout& pipelineLayout, VkPipeline& graphicsPipeline, VkDescriptorSetLayout& descriptorSetLayout, VkFormat& swapchainImageFormat) {
-    auto vertShaderCode = Tools::readFile(Tools::getCompiledShaderFilePath("vertex.spv").c_str());
-    auto fragShaderCode = Tools::readFile(Tools::getCompiledShaderFilePath("fragment.spv").c_str());
+void PipelineCreation::createGraphicsPipeline(VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, VkPhysicalDevice& physicalDevice, VkPipelineLayout& pipelineLayout, VkPipeline& graphicsPipeline, VkDescriptorSetLayout& descriptorSetLayout, VkFormat& swapchainImageFormat) {
+    auto vertShaderCode = shaders.get("vertex.spv");
+    auto fragShaderCode = shaders.get("fragment.spv");
 
     VkShaderModule vertShaderModule = Shaders::createShaderModule(vertShaderCode, device);
     VkShaderModule fragShaderModule = Shaders::createShaderModule(fragShaderCode, device);
@@ -98,7 +104,7 @@ void PipelineCreation::createGraphicsPipeline(VkDevice& device, VkPhysicalDevice
     VkPushConstantRange pushConstantRange = {};
     pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
     pushConstantRange.offset = 0;
-    pushConstantRange.size = sizeof(CullingPushConstants);
+    pushConstantRange.size = sizeof(VertexPushConstants);
 
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -151,7 +157,7 @@ void PipelineCreation::createGraphicsPipeline(VkDevice& device, VkPhysicalDevice
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.pDepthStencilState = &depthStencil;
 
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
 
@@ -159,8 +165,146 @@ void PipelineCreation::createGraphicsPipeline(VkDevice& device, VkPhysicalDevice
     vkDestroyShaderModule(device, vertShaderModule, nullptr);
 }
 
-void PipelineCreation::createMatrixComputePipeline(const VkDevice& device, VkPipelineLayout& matrixComputePipelineLayout, VkPipeline& matrixComputePipeline) {
-    const auto matricesShaderCode = Tools::readFile(Tools::getCompiledShaderFilePath("matrices.spv").c_str());
+void PipelineCreation::createImpostorPipeline(VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, VkPhysicalDevice& physicalDevice, VkPipelineLayout& pipelineLayout, VkPipeline& impostorPipeline, VkDescriptorSetLayout& descriptorSetLayout, VkFormat& swapchainImageFormat) {
+    auto vertShaderCode = shaders.get("impostorVertex.spv");
+    auto fragShaderCode = shaders.get("impostorFragment.spv");
+
+    VkShaderModule vertShaderModule = Shaders::createShaderModule(vertShaderCode, device);
+    VkShaderModule fragShaderModule = Shaders::createShaderModule(fragShaderCode, device);
+
+    VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vertShaderStageInfo.module = vertShaderModule;
+    vertShaderStageInfo.pName = "main";
+
+    VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
+    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragShaderStageInfo.module = fragShaderModule;
+    fragShaderStageInfo.pName = "main";
+
+    VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+
+    // Quads are built from gl_VertexIndex, nothing is bound
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = VK_CULL_MODE_NONE;
+    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizer.depthBiasEnable = VK_FALSE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorBlendAttachment.blendEnable = VK_FALSE;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.logicOp = VK_LOGIC_OP_COPY;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+    colorBlending.blendConstants[0] = 0.0f;
+    colorBlending.blendConstants[1] = 0.0f;
+    colorBlending.blendConstants[2] = 0.0f;
+    colorBlending.blendConstants[3] = 0.0f;
+
+    std::vector<VkDynamicState> dynamicStates = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR
+    };
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamicState.pDynamicStates = dynamicStates.data();
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(ImpostorPushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_TRUE;
+
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+    depthStencil.depthBoundsTestEnable = VK_FALSE;
+    depthStencil.minDepthBounds = 0.0f; // Optional
+    depthStencil.maxDepthBounds = 1.0f; // Optional
+
+    depthStencil.stencilTestEnable = VK_FALSE;
+    depthStencil.front = {}; // Optional
+    depthStencil.back = {}; // Optional
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+
+    VkPipelineRenderingCreateInfo renderingInfo{};
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    renderingInfo.depthAttachmentFormat = Helper::findDepthFormat(physicalDevice);
+    renderingInfo.pColorAttachmentFormats = &swapchainImageFormat;
+    renderingInfo.stencilAttachmentFormat = Helper::findDepthFormat(physicalDevice);
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shaderStages;
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = pipelineLayout;
+    pipelineInfo.pNext = &renderingInfo;
+    pipelineInfo.renderPass = VK_NULL_HANDLE;
+    pipelineInfo.subpass = 0;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+
+    if (vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &impostorPipeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create impostor pipeline!");
+    }
+
+    vkDestroyShaderModule(device, fragShaderModule, nullptr);
+    vkDestroyShaderModule(device, vertShaderModule, nullptr);
+}
+
+void PipelineCreation::createMatrixComputePipeline(const VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, const ShaderSpecialization& specialization, VkPipelineLayout& matrixComputePipelineLayout, VkPipeline& matrixComputePipeline) {
+    const auto matricesShaderCode = shaders.get("matrices.spv");
 
     const VkShaderModule& compShaderModule = Shaders::createShaderModule(matricesShaderCode, device);
 
@@ -170,6 +314,9 @@ void PipelineCreation::createMatrixComputePipeline(const VkDevice& device, VkPip
     compShaderStageInfo.module = compShaderModule;
     compShaderStageInfo.pName = "main";
 
+    const VkSpecializationInfo specializationInfo = specialization.info();
+    compShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
     VkPushConstantRange pushConstantRange = {};
     pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
     pushConstantRange.offset = 0;
@@ -191,14 +338,14 @@ void PipelineCreation::createMatrixComputePipeline(const VkDevice& device, VkPip
     pipelineInfo.stage = compShaderStageInfo;
     pipelineInfo.layout = matrixComputePipelineLayout;
 
-    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &matrixComputePipeline) != VK_SUCCESS) {
+    if (vkCreateComputePipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &matrixComputePipeline) != VK_SUCCESS) {
         throw std::runtime_error("failed to create compute pipeline!");
     }
     vkDestroyShaderModule(device, compShaderModule, nullptr);
 }
 
-void PipelineCreation::createCullingComputePipeline(const VkDevice& device, VkPipelineLayout& cullingComputePipelineLayout, VkPipeline& cullingComputePipeline) {
-    const auto cullingShaderCode = Tools::readFile(Tools::getCompiledShaderFilePath("culling.spv").c_str());
+void PipelineCreation::createCullingComputePipeline(const VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, const ShaderSpecialization& specialization, VkPipelineLayout& cullingComputePipelineLayout, VkPipeline& cullingComputePipeline) {
+    const auto cullingShaderCode = shaders.get("culling.spv");
 
     const VkShaderModule& compShaderModule = Shaders::createShaderModule(cullingShaderCode, device);
 
@@ -208,6 +355,9 @@ void PipelineCreation::createCullingComputePipeline(const VkDevice& device, VkPi
     compShaderStageInfo.module = compShaderModule;
     compShaderStageInfo.pName = "main";
 
+    const VkSpecializationInfo specializationInfo = specialization.info();
+    compShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
     VkPushConstantRange pushConstantRange = {};
     pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
     pushConstantRange.offset = 0;
@@ -229,7 +379,86 @@ void PipelineCreation::createCullingComputePipeline(const VkDevice& device, VkPi
     pipelineInfo.stage = compShaderStageInfo;
     pipelineInfo.layout = cullingComputePipelineLayout;
 
-    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &cullingComputePipeline) != VK_SUCCESS) {
+    if (vkCreateComputePipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &cullingComputePipeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute pipeline!");
+    }
+    vkDestroyShaderModule(device, compShaderModule, nullptr);
+}
+
+void PipelineCreation::createDepthPyramidComputePipeline(const VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, VkPipelineLayout& depthPyramidComputePipelineLayout, VkPipeline& depthPyramidComputePipeline) {
+    const auto depthPyramidShaderCode = shaders.get("depthPyramid.spv");
+
+    const VkShaderModule& compShaderModule = Shaders::createShaderModule(depthPyramidShaderCode, device);
+
+    VkPipelineShaderStageCreateInfo compShaderStageInfo{};
+    compShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    compShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    compShaderStageInfo.module = compShaderModule;
+    compShaderStageInfo.pName = "main";
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(DepthPyramidPushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    pipelineLayoutInfo.setLayoutCount = 0;
+    pipelineLayoutInfo.pSetLayouts = nullptr;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &depthPyramidComputePipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute pipeline layout!");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = compShaderStageInfo;
+    pipelineInfo.layout = depthPyramidComputePipelineLayout;
+
+    if (vkCreateComputePipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &depthPyramidComputePipeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute pipeline!");
+    }
+    vkDestroyShaderModule(device, compShaderModule, nullptr);
+}
+
+void PipelineCreation::createCompactComputePipeline(const VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, const ShaderSpecialization& specialization, VkPipelineLayout& compactComputePipelineLayout, VkPipeline& compactComputePipeline) {
+    const auto compactShaderCode = shaders.get("compact.spv");
+
+    const VkShaderModule& compShaderModule = Shaders::createShaderModule(compactShaderCode, device);
+
+    VkPipelineShaderStageCreateInfo compShaderStageInfo{};
+    compShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    compShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    compShaderStageInfo.module = compShaderModule;
+    compShaderStageInfo.pName = "main";
+
+    const VkSpecializationInfo specializationInfo = specialization.info();
+    compShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(CompactPushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    pipelineLayoutInfo.setLayoutCount = 0;
+    pipelineLayoutInfo.pSetLayouts = nullptr;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &compactComputePipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute pipeline layout!");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = compShaderStageInfo;
+    pipelineInfo.layout = compactComputePipelineLayout;
+
+    if (vkCreateComputePipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &compactComputePipeline) != VK_SUCCESS) {
         throw std::runtime_error("failed to create compute pipeline!");
     }
     vkDestroyShaderModule(device, compShaderModule, nullptr);
@@ -254,11 +483,9 @@ void PipelineCreation::createPostprocessPipelineLayout(const VkDevice &device, V
     }
 }
 
-void PipelineCreation::createPostprocessPipeline(VkDevice& device, VkPhysicalDevice& physicalDevice, VkPipelineLayout& pipelineLayout, VkPipeline& postprocessPipeline, VkDescriptorSetLayout& descriptorSetLayout, VkFormat& swapchainImageFormat, const std::string filename) {
-    const std::string& vertex = Tools::getCompiledShaderFilePath("postprocess.spv");
-    const std::string& fragment = Tools::getCompiledShaderFilePath("postprocessing/" + filename);
-    auto vertShaderCode = Tools::readFile(vertex.c_str());
-    auto fragShaderCode = Tools::readFile(fragment.c_str());
+void PipelineCreation::createPostprocessPipeline(VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, VkPhysicalDevice& physicalDevice, VkPipelineLayout& pipelineLayout, VkPipeline& postprocessPipeline, VkDescriptorSetLayout& descriptorSetLayout, VkFormat& swapchainImageFormat, const std::string filename) {
+    auto vertShaderCode = shaders.get("postprocess.spv");
+    auto fragShaderCode = shaders.get("postprocessing/" + filename);
 
     VkShaderModule vertShaderModule = Shaders::createShaderModule(vertShaderCode, device);
     VkShaderModule fragShaderModule = Shaders::createShaderModule(fragShaderCode, device);
@@ -377,7 +604,7 @@ void PipelineCreation::createPostprocessPipeline(VkDevice& device, VkPhysicalDev
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.pDepthStencilState = &depthStencil;
 
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &postprocessPipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &postprocessPipeline) != VK_SUCCESS) {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
 
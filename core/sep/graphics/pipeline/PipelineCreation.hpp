@@ -8,16 +8,26 @@
 #include <vulkan/vulkan_core.h>
 #include <string>
 
+struct ShaderArchive;
+struct ShaderSpecialization;
+
 struct PipelineCreation {
-    static void createGraphicsPipeline(VkDevice& device, VkPhysicalDevice& physicalDevice, VkPipelineLayout& pipelineLayout, VkPipeline& graphicsPipeline, VkDescriptorSetLayout& descriptorSetLayout, VkFormat& swapchainImageFormat);
+    static void createGraphicsPipeline(VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, VkPhysicalDevice& physicalDevice, VkPipelineLayout& pipelineLayout, VkPipeline& graphicsPipeline, VkDescriptorSetLayout& descriptorSetLayout, VkFormat& swapchainImageFormat);
+
+    // Far band billboards, same descriptor set as the scene
+    static void createImpostorPipeline(VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, VkPhysicalDevice& physicalDevice, VkPipelineLayout& pipelineLayout, VkPipeline& impostorPipeline, VkDescriptorSetLayout& descriptorSetLayout, VkFormat& swapchainImageFormat);
+
+    static void createMatrixComputePipeline(const VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, const ShaderSpecialization& specialization, VkPipelineLayout& matrixComputePipelineLayout, VkPipeline& matrixComputePipeline);
+
+    static void createCullingComputePipeline(const VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, const ShaderSpecialization& specialization, VkPipelineLayout& cullingComputePipelineLayout, VkPipeline& cullingComputePipeline);
 
-    static void createMatrixComputePipeline(const VkDevice& device, VkPipelineLayout& matrixComputePipelineLayout, VkPipeline& matrixComputePipeline);
+    static void createDepthPyramidComputePipeline(const VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, VkPipelineLayout& depthPyramidComputePipelineLayout, VkPipeline& depthPyramidComputePipeline);
 
-    static void createCullingComputePipeline(const VkDevice& device, VkPipelineLayout& cullingComputePipelineLayout, VkPipeline& cullingComputePipeline);
+    static void createCompactComputePipeline(const VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, const ShaderSpecialization& specialization, VkPipelineLayout& compactComputePipelineLayout, VkPipeline& compactComputePipeline);
 
     static void createPostprocessPipelineLayout(const VkDevice &device, VkPipelineLayout &pipelineLayout, const VkDescriptorSetLayout &descriptorSetLayout);
 
-    static void createPostprocessPipeline(VkDevice& device, VkPhysicalDevice& physicalDevice, VkPipelineLayout& pipelineLayout, VkPipeline& postprocessPipeline, VkDescriptorSetLayout& descriptorSetLayout, VkFormat& swapchainImageFormat, const std::string filename);
+    static void createPostprocessPipeline(VkDevice& device, const VkPipelineCache& pipelineCache, const ShaderArchive& shaders, VkPhysicalDevice& physicalDevice, VkPipelineLayout& pipelineLayout, VkPipeline& postprocessPipeline, VkDescriptorSetLayout& descriptorSetLayout, VkFormat& swapchainImageFormat, const std::string filename);
 };
 
 
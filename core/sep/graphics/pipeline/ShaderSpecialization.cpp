@@ -0,0 +1,50 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#include "ShaderSpecialization.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "PhysicalDevice.hpp"
+
+
+const std::array<VkSpecializationMapEntry, 3> ShaderSpecialization::entries{{
+    {0, offsetof(ShaderSpecialization, workgroupSize), sizeof(uint32_t)},
+    {1, offsetof(ShaderSpecialization, culling), sizeof(uint32_t)},
+    {2, offsetof(ShaderSpecialization, lodCount), sizeof(uint32_t)},
+}};
+
+ShaderSpecialization ShaderSpecialization::forDevice(VkPhysicalDevice physicalDevice, const bool culling, const bool impostors) {
+    VkPhysicalDeviceSubgroupProperties subgroupProperties{};
+    PhysicalDevice::getSubgroupProperties(physicalDevice, subgroupProperties);
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    const uint32_t subgroupSize = std::max(subgroupProperties.subgroupSize, 1u);
+    const uint32_t subgroups = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU ? SOFTWARE_SUBGROUPS_PER_GROUP : SUBGROUPS_PER_GROUP;
+    const uint32_t limit = std::min(properties.limits.maxComputeWorkGroupSize[0], properties.limits.maxComputeWorkGroupInvocations);
+
+    ShaderSpecialization specialization{};
+    specialization.workgroupSize = std::max(subgroupSize, std::min(subgroupSize * subgroups, limit / subgroupSize * subgroupSize));
+    specialization.culling = culling ? 1 : 0;
+    specialization.lodCount = impostors ? 2 : 1;
+
+    return specialization;
+}
+
+uint32_t ShaderSpecialization::groupCount(const size_t invocations) const {
+    return static_cast<uint32_t>((invocations + workgroupSize - 1) / workgroupSize);
+}
+
+VkSpecializationInfo ShaderSpecialization::info() const {
+    VkSpecializationInfo info{};
+    info.mapEntryCount = static_cast<uint32_t>(entries.size());
+    info.pMapEntries = entries.data();
+    info.dataSize = sizeof(ShaderSpecialization);
+    info.pData = this;
+
+    return info;
+}
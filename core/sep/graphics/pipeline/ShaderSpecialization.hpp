@@ -0,0 +1,37 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_SHADERSPECIALIZATION_H
+#define INC_2G43S_SHADERSPECIALIZATION_H
+
+#include <array>
+#include <cstdint>
+#include <vulkan/vulkan_core.h>
+
+// Per device shape of the matrix, culling and compaction dispatches, baked into their pipelines as specialization constants.
+// Dispatch math reads the same values, so the shaders and the group counts never disagree
+struct ShaderSpecialization {
+    uint32_t workgroupSize = 128; // constant_id 0, local_size_x, a whole number of subgroups
+    uint32_t culling = 1; // constant_id 1, 0 draws every object and skips every test
+    uint32_t lodCount = 2; // constant_id 2, detail levels culling may pick, 1 is meshes only and 2 adds the impostor band
+
+    // Wave32 and wave64 devices both get four subgroups per group, software rasterizers run a group per
+    // core and want more work per group than a single narrow subgroup. Culling and impostors come from the
+    // renderer's settings, turning them off bakes their branches out of culling.comp
+    static ShaderSpecialization forDevice(VkPhysicalDevice physicalDevice, bool culling, bool impostors);
+
+    [[nodiscard]] uint32_t groupCount(size_t invocations) const;
+
+    // Points into this struct, it has to outlive pipeline creation
+    [[nodiscard]] VkSpecializationInfo info() const;
+
+private:
+    static constexpr uint32_t SUBGROUPS_PER_GROUP = 4;
+    static constexpr uint32_t SOFTWARE_SUBGROUPS_PER_GROUP = 16;
+
+    static const std::array<VkSpecializationMapEntry, 3> entries;
+};
+
+
+#endif //INC_2G43S_SHADERSPECIALIZATION_H
@@ -0,0 +1,196 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#include "ShaderArchive.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SHADER_ARCHIVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Tools.hpp"
+
+
+ShaderArchive::ShaderArchive(ShaderArchive&& other) noexcept
+    : data(std::exchange(other.data, nullptr)), size(std::exchange(other.size, 0)) {}
+
+ShaderArchive& ShaderArchive::operator=(ShaderArchive&& other) noexcept {
+    if (this != &other) {
+        release();
+        data = std::exchange(other.data, nullptr);
+        size = std::exchange(other.size, 0);
+    }
+    return *this;
+}
+
+ShaderArchive::~ShaderArchive() {
+    release();
+}
+
+void ShaderArchive::open(const std::string& path) {
+    release();
+
+#ifdef SHADER_ARCHIVE_MMAP
+    const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) throw std::runtime_error("failed to open shader archive: " + path + "!");
+
+    struct stat status{};
+    if (fstat(file, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(file);
+        throw std::runtime_error("shader archive is truncated: " + path + "!");
+    }
+
+    // The mapping outlives the descriptor, and a repack renames a new file over this one without touching it
+    void* mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (mapping == MAP_FAILED) throw std::runtime_error("failed to map shader archive: " + path + "!");
+
+    data = static_cast<const char*>(mapping);
+    size = static_cast<size_t>(status.st_size);
+#else
+    const std::vector<char> file = Tools::readFile(path.c_str());
+    char* copy = new char[file.size()];
+    memcpy(copy, file.data(), file.size());
+
+    data = copy;
+    size = file.size();
+#endif
+
+    Header header{};
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+        || sizeof(Header) + header.entryCount * sizeof(Entry) > size) {
+        release();
+        throw std::runtime_error("not a version " + std::to_string(VERSION) + " shader archive: " + path + "!");
+    }
+}
+
+std::span<const uint32_t> ShaderArchive::get(const std::string& name) const {
+    for (const Entry& entry : entries()) {
+        if (strncmp(entry.name, name.c_str(), NAME_SIZE) != 0) continue;
+
+        if (entry.offset + entry.size > size || hash(data + entry.offset, entry.size) != entry.hash) {
+            throw std::runtime_error("corrupt shader in archive: " + name + "!");
+        }
+
+        return {reinterpret_cast<const uint32_t*>(data + entry.offset), entry.size / sizeof(uint32_t)};
+    }
+
+    throw std::runtime_error("shader missing from archive: " + name + "!");
+}
+
+std::vector<std::string> ShaderArchive::list(const std::string& directory) const {
+    std::vector<std::string> names{};
+    for (const Entry& entry : entries()) {
+        const std::string name(entry.name, strnlen(entry.name, NAME_SIZE));
+        if (name.starts_with(directory) && name.find('/', directory.size()) == std::string::npos) {
+            names.emplace_back(name.substr(directory.size()));
+        }
+    }
+
+    return names;
+}
+
+void ShaderArchive::release() {
+    if (data == nullptr) return;
+
+#ifdef SHADER_ARCHIVE_MMAP
+    munmap(const_cast<char*>(data), size);
+#else
+    delete[] data;
+#endif
+
+    data = nullptr;
+    size = 0;
+}
+
+void ShaderArchive::pack() {
+    const std::filesystem::path root = Tools::getCompiledShaderPath();
+    if (!std::filesystem::exists(root)) return;
+
+    std::vector<std::pair<std::string, std::vector<char>>> shaders{};
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(root)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".spv") continue;
+
+        std::string name = entry.path().lexically_relative(root).generic_string();
+        if (name.size() >= NAME_SIZE) throw std::runtime_error("shader name too long for the archive: " + name + "!");
+
+        shaders.emplace_back(std::move(name), Tools::readFile(entry.path().string().c_str()));
+    }
+
+    // Stable order, the same shaders always pack into the same bytes
+    std::ranges::sort(shaders, {}, &std::pair<std::string, std::vector<char>>::first);
+
+    Header header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.entryCount = static_cast<uint32_t>(shaders.size());
+
+    std::vector<Entry> table(shaders.size());
+    uint64_t offset = sizeof(Header) + sizeof(Entry) * shaders.size();
+    for (size_t i = 0; i < shaders.size(); ++i) {
+        const auto& [name, code] = shaders[i];
+
+        Entry& entry = table[i];
+        memcpy(entry.name, name.c_str(), name.size() + 1);
+        entry.hash = hash(code.data(), code.size());
+        entry.offset = offset;
+        entry.size = code.size();
+
+        offset += (code.size() + 3) & ~uint64_t{3};
+    }
+
+    const std::string path = getPath();
+    const std::string temporary = path + ".tmp";
+
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) throw std::runtime_error("failed to open shader archive for writing: " + temporary + "!");
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(sizeof(Entry) * table.size()));
+
+    constexpr char padding[4]{};
+    for (const auto& code : shaders | std::views::values) {
+        file.write(code.data(), static_cast<std::streamsize>(code.size()));
+        file.write(padding, static_cast<std::streamsize>(((code.size() + 3) & ~size_t{3}) - code.size()));
+    }
+    file.close();
+
+    std::filesystem::rename(temporary, path);
+}
+
+std::string ShaderArchive::getPath() {
+    return Tools::getCompiledShaderPath() + "shaders.pak";
+}
+
+std::span<const ShaderArchive::Entry> ShaderArchive::entries() const {
+    if (data == nullptr) return {};
+
+    Header header{};
+    memcpy(&header, data, sizeof(header));
+
+    return {reinterpret_cast<const Entry*>(data + sizeof(Header)), header.entryCount};
+}
+
+uint64_t ShaderArchive::hash(const char* bytes, const size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<uint8_t>(bytes[i]);
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
@@ -0,0 +1,68 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_SHADERARCHIVE_H
+#define INC_2G43S_SHADERARCHIVE_H
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// Every compiled shader packed into one file: a header, a table of fixed size entries and the SPIR-V blobs,
+// each 4 byte aligned. Opened archives are memory mapped, shader code is read straight out of the mapping.
+// Owns the mapping, so it moves but never copies and unmaps when destroyed
+struct ShaderArchive {
+    static constexpr char MAGIC[4] = {'S', 'P', 'V', 'A'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t NAME_SIZE = 64;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t _pad;
+    };
+
+    struct Entry {
+        char name[NAME_SIZE]; // Path relative to the compiled shader directory, null terminated
+        uint64_t hash; // FNV-1a of the blob
+        uint64_t offset; // From the start of the file
+        uint64_t size; // Bytes
+    };
+
+    ShaderArchive() = default;
+    ShaderArchive(const ShaderArchive&) = delete;
+    ShaderArchive& operator=(const ShaderArchive&) = delete;
+    ShaderArchive(ShaderArchive&& other) noexcept;
+    ShaderArchive& operator=(ShaderArchive&& other) noexcept;
+    ~ShaderArchive();
+
+    // Maps the archive, an archive opened before is released first
+    void open(const std::string& path);
+
+    // Code of a shader by its compiled name ("vertex.spv", "postprocessing/hdr.spv"), throws if it isn't packed
+    [[nodiscard]] std::span<const uint32_t> get(const std::string& name) const;
+
+    // Compiled names of every packed shader under a directory, "postprocessing/" gives "hdr.spv" and so on
+    [[nodiscard]] std::vector<std::string> list(const std::string& directory) const;
+
+    // Packs every .spv under the compiled shader directory, written aside and renamed over the old archive
+    static void pack();
+
+    static std::string getPath();
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+
+    void release();
+
+    [[nodiscard]] std::span<const Entry> entries() const;
+
+    static uint64_t hash(const char* bytes, size_t size);
+};
+
+
+#endif //INC_2G43S_SHADERARCHIVE_H
@@ -0,0 +1,152 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#include "ShaderHotReload.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "Logger.hpp"
+#include "ShaderArchive.hpp"
+#include "Shaders.hpp"
+#include "Tools.hpp"
+
+
+ShaderHotReload::~ShaderHotReload() {
+    stop();
+}
+
+void ShaderHotReload::start(PipelineFactory factory) {
+#ifdef __linux__
+    this->factory = std::move(factory);
+
+    inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify < 0) {
+        Logger("ShaderHotReload").warn("Shader hot reload disabled, inotify_init1 failed");
+        return;
+    }
+
+    watch(Tools::getShaderPath());
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(Tools::getShaderPath())) {
+        if (entry.is_directory()) watch(entry.path());
+    }
+
+    worker = std::jthread([this](const std::stop_token& token) { run(token); });
+#endif
+}
+
+void ShaderHotReload::stop() {
+    if (worker.joinable()) {
+        worker.request_stop();
+        worker.join();
+    }
+
+#ifdef __linux__
+    if (inotify >= 0) {
+        close(inotify);
+        inotify = -1;
+    }
+#endif
+
+    watches.clear();
+}
+
+std::vector<std::pair<std::string, VkPipeline>> ShaderHotReload::takeReady() {
+    const std::lock_guard lock(readyMutex);
+    return std::exchange(ready, {});
+}
+
+void ShaderHotReload::watch(const std::filesystem::path& directory) {
+#ifdef __linux__
+    // Output of the compiler itself, watching it would reload forever
+    if (directory.string().contains("compiled")) return;
+
+    const int descriptor = inotify_add_watch(inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (descriptor >= 0) watches[descriptor] = directory;
+#endif
+}
+
+bool ShaderHotReload::readEvents() {
+    bool changed = false;
+
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+
+    ssize_t length;
+    while ((length = read(inotify, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->len == 0 || !watches.contains(event->wd)) continue;
+            const std::filesystem::path path = watches[event->wd] / event->name;
+
+            if (event->mask & IN_ISDIR) {
+                watch(path);
+                changed = true;
+            } else if (!(event->mask & IN_CREATE)) {
+                // Included files have any extension, the content hash sorts out what actually changed
+                changed |= !path.string().contains("compiled") && path.filename() != "cache.json" && path.extension() != ".tmp";
+            }
+        }
+    }
+#endif
+
+    return changed;
+}
+
+void ShaderHotReload::run(const std::stop_token& token) {
+#ifdef __linux__
+    while (!token.stop_requested()) {
+        pollfd descriptor{inotify, POLLIN, 0};
+        if (poll(&descriptor, 1, POLL_TIMEOUT_MS) <= 0 || !readEvents()) continue;
+
+        std::this_thread::sleep_for(DEBOUNCE);
+        readEvents();
+
+        reload();
+    }
+#endif
+}
+
+void ShaderHotReload::reload() {
+    const std::vector<std::filesystem::path> compiled = Shaders::compileShaders();
+    if (compiled.empty()) return;
+
+    Logger LOGGER{"ShaderHotReload"};
+
+    // Own mapping, the render thread keeps reading the one it opened
+    ShaderArchive shaders{};
+    try {
+        shaders.open(ShaderArchive::getPath());
+    } catch (const std::exception& exception) {
+        LOGGER.error("Failed to reload shaders: ${}", exception.what());
+        return;
+    }
+
+    // Other pipelines pick their shaders up on the next start
+    std::vector<std::string> filenames{};
+    for (const auto& shader : compiled) {
+        if (shader.filename() == POSTPROCESS_VERTEX) {
+            filenames = shaders.list("postprocessing/");
+            break;
+        }
+
+        if (shader.string().contains("postprocessing")) filenames.emplace_back(shader.filename().replace_extension(".spv").string());
+    }
+
+    for (const std::string& filename : filenames) {
+        try {
+            VkPipeline pipeline = factory(shaders, filename);
+
+            const std::lock_guard lock(readyMutex);
+            ready.emplace_back(filename, pipeline);
+        } catch (const std::exception& exception) {
+            LOGGER.error("Failed to rebuild ${}: ${}", filename, exception.what());
+        }
+    }
+}
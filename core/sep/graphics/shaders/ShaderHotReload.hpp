@@ -0,0 +1,68 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_SHADERHOTRELOAD_H
+#define INC_2G43S_SHADERHOTRELOAD_H
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+struct ShaderArchive;
+
+// Watches the shader tree (inotify) and recompiles what changed on its own thread. Postprocessing pipelines of
+// the recompiled shaders (all of them when their vertex stage changed) are built there as well and wait in a queue, the render thread swaps them in between frames.
+// A no-op where inotify doesn't exist
+struct ShaderHotReload {
+    // Builds the postprocessing pipeline of a compiled .spv name from the freshly packed archive, called on the watcher thread
+    using PipelineFactory = std::function<VkPipeline(const ShaderArchive& shaders, const std::string& filename)>;
+
+    ShaderHotReload() = default;
+    ShaderHotReload(const ShaderHotReload&) = delete;
+    ShaderHotReload& operator=(const ShaderHotReload&) = delete;
+    ~ShaderHotReload();
+
+    void start(PipelineFactory factory);
+
+    // Joins the watcher, pipelines still queued are left for takeReady
+    void stop();
+
+    // Pipelines built since the last call, by postprocessing .spv name
+    std::vector<std::pair<std::string, VkPipeline>> takeReady();
+
+private:
+    // Editors save in bursts, changes within this window are compiled together
+    static constexpr std::chrono::milliseconds DEBOUNCE{50};
+    static constexpr int POLL_TIMEOUT_MS = 100; // How late a stop request may be noticed
+    static constexpr const char* POSTPROCESS_VERTEX = "postprocess.vert"; // Shared by every postprocessing pipeline
+
+    PipelineFactory factory{};
+
+    int inotify = -1;
+    std::unordered_map<int, std::filesystem::path> watches{};
+
+    std::mutex readyMutex{};
+    std::vector<std::pair<std::string, VkPipeline>> ready{};
+
+    std::jthread worker{};
+
+    void watch(const std::filesystem::path& directory);
+
+    // Drains pending events, true if a shader source or a new directory showed up
+    bool readEvents();
+
+    void run(const std::stop_token& token);
+
+    void reload();
+};
+
+
+#endif //INC_2G43S_SHADERHOTRELOAD_H
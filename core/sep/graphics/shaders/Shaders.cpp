@@ -4,13 +4,66 @@
 
 #include "Shaders.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "ShaderArchive.hpp"
 #include "Tools.hpp"
 
+// Bump when anything that changes the output but isn't in the compile options changes
+static constexpr std::string_view CACHE_VERSION = "2";
+
+// Resolves #include "x" next to the including file, <x> from the shader root
+class ShaderIncluder final : public shaderc::CompileOptions::IncluderInterface {
+    struct Include {
+        std::string name;
+        std::string content;
+        shaderc_include_result result{};
+    };
+
+public:
+    shaderc_include_result* GetInclude(const char* requested, const shaderc_include_type type, const char* requesting, size_t) override {
+        const std::filesystem::path base = type == shaderc_include_type_relative
+            ? std::filesystem::path(Tools::getShaderPath()) / std::filesystem::path(requesting).parent_path()
+            : std::filesystem::path(Tools::getShaderPath());
+        const std::filesystem::path path = (base / requested).lexically_normal();
+
+        auto* include = new Include{};
+        std::ifstream stream{path};
+        if (stream.is_open()) {
+            std::stringstream buffer;
+            buffer << stream.rdbuf();
+
+            include->name = path.lexically_relative(Tools::getShaderPath()).string();
+            include->content = buffer.str();
+        } else {
+            // Empty name is how shaderc is told the include failed, content is the error
+            include->content = "cannot open " + path.string();
+        }
+
+        include->result = {include->name.c_str(), include->name.size(), include->content.c_str(), include->content.size(), include};
+        return &include->result;
+    }
+
+    void ReleaseInclude(shaderc_include_result* data) override {
+        delete static_cast<Include*>(data->user_data);
+    }
+};
+
 VkShaderModule Shaders::createShaderModule(const std::vector<char>& code, const VkDevice& device) {
+    return createShaderModule(std::span{reinterpret_cast<const uint32_t*>(code.data()), code.size() / sizeof(uint32_t)}, device);
+}
+
+VkShaderModule Shaders::createShaderModule(const std::span<const uint32_t> code, const VkDevice& device) {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    createInfo.codeSize = code.size_bytes();
+    createInfo.pCode = code.data();
 
     VkShaderModule shaderModule;
     if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
@@ -51,62 +104,103 @@ void Shaders::saveShaderToFile(const std::string& path, const std::vector<uint32
 
 
 #pragma region Compilation
-std::vector<std::filesystem::path> Shaders::getShadersToCompile() {
-    std::vector<std::filesystem::path> shaders = getShaders();
-    std::vector<std::filesystem::path> dirtyShaders{};
-    std::ifstream file(Tools::getShaderPath() + "cache.json");
-    nlohmann::json cache;
-
-    if (!file.fail()) {
-        if (nlohmann::json::accept(file)) {
-            file.seekg(0);
-            cache = nlohmann::json::parse(file);
-        } else {
-            createCache(shaders);
-        }
-    } else {
-        cache = createCache(shaders);
+std::vector<std::filesystem::path> Shaders::compileShaders() {
+    // Hot reload and F3 may both compile, only one of them owns the cache at a time
+    static std::mutex compileMutex;
+    const std::lock_guard compileLock(compileMutex);
+
+    const std::vector<std::filesystem::path> shaders = getShaders();
+    nlohmann::json cache = loadCache();
+
+    struct Job {
+        std::filesystem::path path;
+        std::string key; // Relative to the shader root
+        std::string source;
+        std::string hash;
+        bool compiled = false;
+    };
+
+    std::vector<Job> jobs(shaders.size());
+    for (size_t i = 0; i < shaders.size(); ++i) {
+        jobs[i].path = shaders[i];
+        jobs[i].key = shaders[i].lexically_relative(Tools::getShaderPath()).string();
     }
 
+    // Spreads work over the jobs, one compiler per thread
+    const auto forEach = [&jobs](const std::function<void(const shaderc::Compiler&, Job&)>& work) {
+        std::atomic<size_t> next = 0;
+        const size_t threadCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, std::max<size_t>(jobs.size(), 1));
+
+        std::vector<std::thread> threads{};
+        threads.reserve(threadCount);
+        for (size_t t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&] {
+                const shaderc::Compiler compiler;
+                for (size_t i = next++; i < jobs.size(); i = next++) work(compiler, jobs[i]);
+            });
+        }
 
-    for (const auto& entry : shaders) {
-        auto time = std::chrono::file_clock::to_sys(std::filesystem::last_write_time(entry)).time_since_epoch().count();
-        auto cacheTime = cache[entry.lexically_relative(Tools::getShaderPath()).string()];
-        if (cacheTime != time) {
-            dirtyShaders.emplace_back(entry.string());
+        for (auto& thread : threads) thread.join();
+    };
+
+    // Preprocessing resolves includes, an edited include changes the hash of everything using it
+    forEach([](const shaderc::Compiler& compiler, Job& job) {
+        std::ifstream stream{job.path};
+        std::stringstream buffer;
+        buffer << stream.rdbuf();
+        job.source = buffer.str();
+
+        const std::string preprocessed = preprocessShader(compiler, job.path, job.source);
+        if (!preprocessed.empty()) job.hash = hashShader(preprocessed);
+    });
+
+    std::erase_if(jobs, [&cache](const Job& job) {
+        const auto it = cache.find(job.key);
+        return !job.hash.empty() && it != cache.end() && *it == job.hash && std::filesystem::exists(getCompiledPath(job.path));
+    });
+
+    std::mutex outputMutex;
+    forEach([&outputMutex](const shaderc::Compiler& compiler, Job& job) {
+        const std::vector<uint32_t> spirv = compileShader(compiler, job.path, job.source);
+        if (spirv.empty()) return;
+
+        const std::string output = getCompiledPath(job.path);
+        std::filesystem::create_directories(std::filesystem::path(output).parent_path());
+        saveShaderToFile(output, spirv);
+        job.compiled = true;
+
+        const std::lock_guard lock(outputMutex);
+        std::cout << "Compiled shader: " << job.key << std::endl;
+    });
+
+    std::vector<std::filesystem::path> compiled{};
+    for (const auto& job : jobs) {
+        // Failed ones stay out of the cache and are retried next time
+        if (job.compiled) {
+            cache[job.key] = job.hash;
+            compiled.emplace_back(job.path);
+        } else {
+            cache.erase(job.key);
         }
     }
 
-    return dirtyShaders;
-}
-
-
-std::vector<uint32_t> Shaders::compileShader(const std::filesystem::path& file) {
-    shaderc::Compiler compiler;
-    shaderc::CompileOptions options;
+    if (!jobs.empty()) saveCache(cache);
+    if (!jobs.empty() || !std::filesystem::exists(ShaderArchive::getPath())) ShaderArchive::pack();
 
-    options.SetOptimizationLevel(shaderc_optimization_level_performance);
-    options.SetTargetSpirv(shaderc_spirv_version_1_6);
-    options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_4);
-
-    std::ifstream stream{file};
-    std::stringstream buffer;
-    buffer << stream.rdbuf();
+    return compiled;
+}
 
-    std::string source = buffer.str();
-    std::filesystem::path filename = file.lexically_relative(Tools::getShaderPath());
+std::vector<uint32_t> Shaders::compileShader(const shaderc::Compiler& compiler, const std::filesystem::path& file, const std::string& source) {
+    const std::string filename = file.lexically_relative(Tools::getShaderPath()).string();
 
     std::vector<uint32_t> shader{};
 
-    shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(
-        source, Tools::getShaderKind(file.extension()), filename.c_str(), options);
+    const shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(
+        source, Tools::getShaderKind(file.extension()), filename.c_str(), getCompileOptions());
 
     if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
         std::cerr << "Shader Compilation Error: " << result.GetErrorMessage() << std::endl;
     } else {
-        std::cout << "Compiled shader: " << filename << std::endl;
-
-        addCacheEntry(file);
 #if __cpp_lib_containers_ranges >= 202202L
         shader.append_range(result);
 #else
@@ -116,41 +210,71 @@ std::vector<uint32_t> Shaders::compileShader(const std::filesystem::path& file)
 
     return shader;
 }
+
+std::string Shaders::preprocessShader(const shaderc::Compiler& compiler, const std::filesystem::path& file, const std::string& source) {
+    const std::string filename = file.lexically_relative(Tools::getShaderPath()).string();
+
+    const shaderc::PreprocessedSourceCompilationResult result = compiler.PreprocessGlsl(
+        source, Tools::getShaderKind(file.extension()), filename.c_str(), getCompileOptions());
+
+    if (result.GetCompilationStatus() != shaderc_compilation_status_success) return {};
+
+    return {result.cbegin(), result.cend()};
+}
+
+shaderc::CompileOptions Shaders::getCompileOptions() {
+    shaderc::CompileOptions options;
+
+    options.SetOptimizationLevel(shaderc_optimization_level_performance);
+    options.SetTargetSpirv(shaderc_spirv_version_1_6);
+    options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_4);
+    options.SetIncluder(std::make_unique<ShaderIncluder>());
+
+    return options;
+}
 #pragma endregion
 
 
 #pragma region Cache
-nlohmann::json Shaders::createCache(const std::vector<std::filesystem::path>& shaders) {
-    nlohmann::json cache;
-    for (const auto& shader : shaders) {
-        auto time = std::filesystem::last_write_time(shader);
-        auto systemTime = std::chrono::file_clock::to_sys(time);
-
-        cache[shader.lexically_relative(Tools::getShaderPath())] = systemTime.time_since_epoch().count();
+std::string Shaders::hashShader(const std::string& preprocessed) {
+    // Has to change whenever getCompileOptions does
+    const std::string options = std::format("{};performance;spirv1.6;vulkan1.4;", CACHE_VERSION);
+
+    uint64_t hash = 14695981039346656037ull;
+    for (const std::string* part : {&options, &preprocessed}) {
+        for (const char c : *part) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ull;
+        }
     }
 
-    std::ofstream file(Tools::getShaderPath() + "cache.json");
-    file << cache.dump(0);
-
-    file.close();
+    return std::format("{:016x}", hash);
+}
 
-    return cache;
+std::string Shaders::getCompiledPath(const std::filesystem::path& shader) {
+    return Tools::getCompiledShaderPath() + std::filesystem::path(shader).lexically_relative(Tools::getShaderPath()).replace_extension(".spv").string();
 }
 
-nlohmann::json Shaders::addCacheEntry(std::filesystem::path shader) {
+nlohmann::json Shaders::loadCache() {
     std::ifstream file(Tools::getShaderPath() + "cache.json");
-    nlohmann::json cache = nlohmann::json::parse(file);
+    if (file.fail()) return nlohmann::json::object();
 
-    auto time = std::filesystem::last_write_time(shader);
-    auto systemTime = std::chrono::file_clock::to_sys(time);
+    nlohmann::json cache = nlohmann::json::parse(file, nullptr, false);
+    if (!cache.is_object()) return nlohmann::json::object();
 
-    cache[shader.lexically_relative(Tools::getShaderPath())] = systemTime.time_since_epoch().count();
+    return cache;
+}
 
-    std::ofstream file1(Tools::getShaderPath() + "cache.json");
-    file1 << cache.dump(0);
+void Shaders::saveCache(const nlohmann::json& cache) {
+    const std::string path = Tools::getShaderPath() + "cache.json";
+    const std::string temporary = path + ".tmp";
 
-    file1.close();
+    std::ofstream file(temporary, std::ios::trunc);
+    file << cache.dump(0);
+    file.close();
 
-    return cache;
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) std::cerr << "Failed to save shader cache: " << error.message() << std::endl;
 }
 #pragma endregion
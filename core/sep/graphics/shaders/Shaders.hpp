@@ -6,6 +6,7 @@
 #define INC_2G43S_SHADER_H
 
 #include <filesystem>
+#include <span>
 #include <string>
 #include <vector>
 #include <vulkan/vulkan_core.h>
@@ -20,19 +21,34 @@
 struct Shaders {
     static VkShaderModule createShaderModule(const std::vector<char>& code, const VkDevice& device);
 
-    static std::vector<std::filesystem::path> getShaders();
+    static VkShaderModule createShaderModule(std::span<const uint32_t> code, const VkDevice& device);
 
-    static std::vector<std::filesystem::path> getShadersToCompile();
+    static std::vector<std::filesystem::path> getShaders();
 
     static void saveShaderToFile(const std::string& path, const std::vector<uint32_t>& spirv);
 
-    static std::vector<uint32_t> compileShader(const std::filesystem::path& file);
+    // Compiles every shader whose preprocessed source or compile options changed since the last run,
+    // spread over all cores, then repacks the shader archive. Returns the shaders that were compiled successfully
+    static std::vector<std::filesystem::path> compileShaders();
+
+    static std::vector<uint32_t> compileShader(const shaderc::Compiler& compiler, const std::filesystem::path& file, const std::string& source);
+
+    // Source with every #include resolved, empty if preprocessing failed
+    static std::string preprocessShader(const shaderc::Compiler& compiler, const std::filesystem::path& file, const std::string& source);
+
+    static shaderc::CompileOptions getCompileOptions();
+
+    // FNV-1a of the preprocessed source and the options, hex
+    static std::string hashShader(const std::string& preprocessed);
+
+    static std::string getCompiledPath(const std::filesystem::path& shader);
 
-    static nlohmann::json createCache(const std::vector<std::filesystem::path>& shaders);
+    static nlohmann::json loadCache();
 
-    static nlohmann::json addCacheEntry(std::filesystem::path shader);
+    // Written aside and renamed over the old cache
+    static void saveCache(const nlohmann::json& cache);
 
 };
 
 
-#endif //INC_2G43S_SHADER_H
\ No newline at end of file
+#endif //INC_2G43S_SHADER_H
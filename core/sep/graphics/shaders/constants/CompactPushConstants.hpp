@@ -0,0 +1,16 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_COMPACTPUSHCONSTANTS_H
+#define INC_2G43S_COMPACTPUSHCONSTANTS_H
+#include <cstdint>
+
+struct CompactPushConstants {
+    uint64_t commands;
+    uint64_t compacted;
+    uint64_t counter;
+    uint32_t commandCount;
+};
+
+#endif //INC_2G43S_COMPACTPUSHCONSTANTS_H
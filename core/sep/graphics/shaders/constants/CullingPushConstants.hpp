@@ -13,6 +13,11 @@ struct CullingPushConstants {
     uint64_t dcb;
     uint64_t ucbo;
     uint64_t counter;
+    uint64_t lateVib;
+    uint64_t visibility;
+    uint64_t pyramid;
+    uint64_t impostors;
+    uint32_t phase;
 };
 
 #endif //INC_2G43S_CULLINGPUSHCONSTANTS_H
\ No newline at end of file
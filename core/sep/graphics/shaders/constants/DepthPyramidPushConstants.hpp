@@ -0,0 +1,20 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_DEPTHPYRAMIDPUSHCONSTANTS_H
+#define INC_2G43S_DEPTHPYRAMIDPUSHCONSTANTS_H
+#include <cstdint>
+
+struct DepthPyramidPushConstants {
+    uint64_t pyramid;
+    uint32_t srcOffset;
+    uint32_t srcWidth;
+    uint32_t srcHeight;
+    uint32_t dstOffset;
+    uint32_t dstWidth;
+    uint32_t dstHeight;
+    uint32_t unorm24;
+};
+
+#endif //INC_2G43S_DEPTHPYRAMIDPUSHCONSTANTS_H
@@ -0,0 +1,19 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_IMPOSTORPUSHCONSTANTS_H
+#define INC_2G43S_IMPOSTORPUSHCONSTANTS_H
+#include <cstdint>
+
+struct ImpostorPushConstants {
+    uint64_t ubo;
+    uint64_t mb;
+    uint64_t mcb;
+    uint64_t impostors;
+    uint32_t atlasSlot;
+    uint32_t views;
+    uint32_t rows;
+};
+
+#endif //INC_2G43S_IMPOSTORPUSHCONSTANTS_H
@@ -10,8 +10,7 @@ struct VertexPushConstants {
     uint64_t ubo;
     uint64_t mb;
     uint64_t vib;
-    uint64_t ti;
-    uint64_t tio;
+    uint64_t materials;
 };
 
 #endif //INC_2G43S_VERTEXPUSHCONSTANTS_H
\ No newline at end of file
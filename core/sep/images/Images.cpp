@@ -10,7 +10,7 @@
 #include "basisu_transcoder.h"
 #include "Logger.hpp"
 
-void Images::createImage(const VkDevice& device, const VkPhysicalDevice& physicalDevice, const uint32_t width, const uint32_t height, const VkFormat format, const VkImageTiling tiling, const VkImageUsageFlags usage, const VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory) {
+void Images::createImage(const VkDevice& device, const VkPhysicalDevice& physicalDevice, const uint32_t width, const uint32_t height, const VkFormat format, const VkImageTiling tiling, const VkImageUsageFlags usage, const VkMemoryPropertyFlags properties, VkImage& image, GpuAllocation& imageMemory) {
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -33,16 +33,15 @@ void Images::createImage(const VkDevice& device, const VkPhysicalDevice& physica
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(device, image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = Helper::findMemoryType(memRequirements.memoryTypeBits, properties, physicalDevice);
+    const GpuResourceKind kind = tiling == VK_IMAGE_TILING_OPTIMAL ? GpuResourceKind::Optimal : GpuResourceKind::Linear;
+    imageMemory = GpuAllocator::allocate(device, physicalDevice, memRequirements, properties, kind);
 
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate image memory!");
-    }
+    vkBindImageMemory(device, image, imageMemory.memory, imageMemory.offset);
+}
 
-    vkBindImageMemory(device, image, imageMemory, 0);
+void Images::destroyImage(const VkDevice& device, const VkImage& image, const GpuAllocation& imageMemory) {
+    vkDestroyImage(device, image, nullptr);
+    GpuAllocator::free(device, imageMemory);
 }
 
 VkImageView Images::createImageView(const VkDevice& device, const VkImage& image, const VkFormat& format, const VkImageAspectFlags& aspectFlags) {
@@ -66,7 +65,7 @@ VkImageView Images::createImageView(const VkDevice& device, const VkImage& image
 }
 
 
-void Images::createTextureImage(const VkDevice& device, const VkCommandPool& commandPool, const VkQueue& graphicsQueue, const VkPhysicalDevice& physicalDevice, VkBuffer& stagingBuffer, VkDeviceMemory& stagingBufferMemory, VkImage& textureImage, VkDeviceMemory& textureImageMemory, std::string filePath, VkFormat format) {
+UploadService::Ticket Images::createTextureImage(const VkDevice& device, const VkPhysicalDevice& physicalDevice, UploadService& uploads, VkImage& textureImage, GpuAllocation& textureImageMemory, std::string filePath, VkFormat format) {
     std::ifstream file(filePath, std::ios::binary | std::ios::ate);
     if (!file.is_open()) {
         throw std::runtime_error("failed to open texture file: " + filePath);
@@ -95,61 +94,40 @@ void Images::createTextureImage(const VkDevice& device, const VkCommandPool& com
     uint32_t bytesPerBlock = basist::basis_get_bytes_per_block_or_pixel(targetBasisFormat);
     VkDeviceSize imageSize = info.m_total_blocks * bytesPerBlock;
 
-
-    BuffersRegistry::createBuffer(device, physicalDevice, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-    void* mappedData;
-    vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &mappedData);
+    // Transcoded straight into the staging memory
+    const UploadService::Staging staging = uploads.stage(imageSize);
 
     bool ok = transcoder.transcode_image_level(
     levelIndex, layerIndex, faceIndex,
-       mappedData,
+       staging.mapped,
        info.m_total_blocks,
        targetBasisFormat
     );
 
-    vkUnmapMemory(device, stagingBufferMemory);
-
     if (!ok) {
-        vkDestroyBuffer(device, stagingBuffer, nullptr);
-        vkFreeMemory(device, stagingBufferMemory, nullptr);
+        BuffersRegistry::destroyBuffer(device, staging.buffer, staging.memory);
         throw std::runtime_error("failed to transcode KTX2 file!");
     }
 
     createImage(device, physicalDevice, info.m_width, info.m_height, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
 
-    transitionImageLayout(device, commandPool, graphicsQueue, textureImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    copyBufferToImage(device, commandPool, graphicsQueue, stagingBuffer, textureImage, static_cast<uint32_t>(info.m_width), static_cast<uint32_t>(info.m_height));
-    transitionImageLayout(device, commandPool, graphicsQueue, textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    return uploads.copy(staging, textureImage, static_cast<uint32_t>(info.m_width), static_cast<uint32_t>(info.m_height));
 }
 
-void Images::createTextureImage(const VkDevice& device, const VkCommandPool& commandPool, const VkQueue& graphicsQueue, const VkPhysicalDevice& physicalDevice, VkBuffer& stagingBuffer, VkDeviceMemory& stagingBufferMemory, Texture& texture) {
+UploadService::Ticket Images::createTextureImage(const VkDevice& device, const VkPhysicalDevice& physicalDevice, UploadService& uploads, Texture& texture) {
     Logger LOGGER("createTextureImage()");
     if (!texture.pixels) {
         LOGGER.error("No image provided!");
-        return;
+        return 0;
     }
 
-    BuffersRegistry::createBuffer(device, physicalDevice, texture.imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-    void* data;
-    vkMapMemory(device, stagingBufferMemory, 0, texture.imageSize, 0, &data);
-    memcpy(data, texture.pixels, texture.imageSize);
-    vkUnmapMemory(device, stagingBufferMemory);
-
     createImage(device, physicalDevice, texture.texWidth, texture.texHeight, texture.format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture.textureImage, texture.textureImageMemory);
 
-    transitionImageLayout(device, commandPool, graphicsQueue, texture.textureImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    copyBufferToImage(device, commandPool, graphicsQueue, stagingBuffer, texture.textureImage, static_cast<uint32_t>(texture.texWidth), static_cast<uint32_t>(texture.texHeight));
-    transitionImageLayout(device, commandPool, graphicsQueue, texture.textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    const UploadService::Ticket ticket = uploads.upload(texture.textureImage, static_cast<uint32_t>(texture.texWidth), static_cast<uint32_t>(texture.texHeight), texture.pixels, texture.imageSize);
 
     texture.deleteImage();
+
+    return ticket;
 }
 
 void Images::createTextureImageView(const VkDevice& device, const VkImage& textureImage, VkImageView& textureImageView, VkFormat format) {
@@ -198,89 +176,3 @@ void Images::createTextureSampler(const VkDevice& device, const VkPhysicalDevice
         throw std::runtime_error("failed to create texture sampler!");
     }
 }
-
-void Images::copyBufferToImage(const VkDevice& device, const VkCommandPool& commandPool, const VkQueue& graphicsQueue, const VkBuffer& buffer, const VkImage& image, const uint32_t& width, const uint32_t& height) {
-    const VkCommandBuffer& commandBuffer = Command::beginSingleTimeCommands(device, commandPool);
-
-    VkBufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-
-    region.imageOffset = {0, 0, 0};
-    region.imageExtent = {
-        width,
-        height,
-        1
-    };
-
-    vkCmdCopyBufferToImage(
-        commandBuffer,
-        buffer,
-        image,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        1,
-        &region
-    );
-
-    Command::endSingleTimeCommands(device, commandBuffer, commandPool, graphicsQueue);
-}
-
-void Images::transitionImageLayout(const VkDevice& device, const VkCommandPool& commandPool, const VkQueue& graphicsQueue, const VkImage& image, const VkImageLayout& oldLayout, const VkImageLayout& newLayout) {
-    const VkCommandBuffer& commandBuffer = Command::beginSingleTimeCommands(device, commandPool);
-
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = oldLayout;
-    barrier.newLayout = newLayout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = image;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-
-    VkPipelineStageFlags sourceStage;
-    VkPipelineStageFlags destinationStage;
-
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    } else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    } else {
-        throw std::invalid_argument("unsupported layout transition!");
-    }
-
-
-    vkCmdPipelineBarrier(
-        commandBuffer,
-        sourceStage, destinationStage,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier
-    );
-
-    Command::endSingleTimeCommands(device, commandBuffer, commandPool, graphicsQueue);
-}
\ No newline at end of file
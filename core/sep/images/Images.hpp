@@ -13,28 +13,26 @@
 
 #include "BuffersRegistry.hpp"
 #include "Command.hpp"
+#include "UploadService.hpp"
 #include "../graphics/helper/Helper.hpp"
 
 
 struct Images {
     // Image
-    static void createImage(const VkDevice& device, const VkPhysicalDevice& physicalDevice, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+    static void createImage(const VkDevice& device, const VkPhysicalDevice& physicalDevice, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, GpuAllocation& imageMemory);
+
+    static void destroyImage(const VkDevice& device, const VkImage& image, const GpuAllocation& imageMemory);
 
     static VkImageView createImageView(const VkDevice& device, const VkImage& image, const VkFormat& format, const VkImageAspectFlags& aspectFlags);
 
-    // Texture
-    static void createTextureImage(const VkDevice& device, const VkCommandPool& commandPool, const VkQueue& graphicsQueue, const VkPhysicalDevice& physicalDevice, VkBuffer& stagingBuffer, VkDeviceMemory& stagingBufferMemory, VkImage& textureImage, VkDeviceMemory& textureImageMemory, std::string filePath, VkFormat format);
+    // Texture, uploaded through the upload service and usable once the returned ticket completed
+    static UploadService::Ticket createTextureImage(const VkDevice& device, const VkPhysicalDevice& physicalDevice, UploadService& uploads, VkImage& textureImage, GpuAllocation& textureImageMemory, std::string filePath, VkFormat format);
 
-    static void createTextureImage(const VkDevice& device, const VkCommandPool& commandPool, const VkQueue& graphicsQueue, const VkPhysicalDevice& physicalDevice, VkBuffer& stagingBuffer, VkDeviceMemory& stagingBufferMemory, Texture& texture);
+    static UploadService::Ticket createTextureImage(const VkDevice& device, const VkPhysicalDevice& physicalDevice, UploadService& uploads, Texture& texture);
 
     static void createTextureImageView(const VkDevice& device, const VkImage& textureImage, VkImageView& textureImageView, VkFormat format);
 
     static void createTextureSampler(const VkDevice& device, const VkPhysicalDevice& physicalDevice, VkSampler& textureSampler);
-
-    // Helper
-    static void copyBufferToImage(const VkDevice& device, const VkCommandPool& commandPool, const VkQueue& graphicsQueue, const VkBuffer& buffer, const VkImage& image, const uint32_t& width, const uint32_t& height);
-
-    static void transitionImageLayout(const VkDevice& device, const VkCommandPool& commandPool, const VkQueue& graphicsQueue, const VkImage& image, const VkImageLayout& oldLayout, const VkImageLayout& newLayout);
 };
 
 
@@ -6,6 +6,8 @@
 #define INC_2G43S_TEXTURE_H
 #include <vulkan/vulkan_core.h>
 
+#include "GpuAllocator.hpp"
+
 
 struct Texture {
     uint8_t* pixels{};
@@ -16,13 +18,12 @@ struct Texture {
 
     // Texture indexing in fragment shader
     size_t index{};
-    size_t indexOffset{};
 
     // Vulkan
     VkFormat format = VK_FORMAT_UNDEFINED;
     VkImage textureImage = VK_NULL_HANDLE;
     VkImageView textureImageView = VK_NULL_HANDLE;
-    VkDeviceMemory textureImageMemory = VK_NULL_HANDLE;
+    GpuAllocation textureImageMemory{};
 
     void deleteImage() const {
         delete[] pixels;
@@ -14,7 +14,7 @@ inline static std::unordered_map<fastgltf::MimeType, std::string> mimeTypes = {
     {fastgltf::MimeType::WEBP, "webp"},
 };
 
-void ParsedModel::loadModel(const std::filesystem::path& path) {
+void ParsedModel::loadModel(const std::filesystem::path& path, const bool collisionOnly) {
     auto LOGGER = Logger("loadModel()");
 
     // Basically all the necessary options and extensions
@@ -105,7 +105,7 @@ void ParsedModel::loadModel(const std::filesystem::path& path) {
 
             // UV
             auto* texcoord = primitive.findAttribute("TEXCOORD_0");
-            if (texcoord != nullptr) {
+            if (texcoord != nullptr && !collisionOnly) {
                 auto& texcoordAccessor = asset.accessors[texcoord->accessorIndex];
 
                 if (texcoordAccessor.type == fastgltf::AccessorType::Vec2) {
@@ -135,7 +135,8 @@ void ParsedModel::loadModel(const std::filesystem::path& path) {
 
             this->meshes.emplace_back(std::move(tempMesh));
 
-            if (primitive.materialIndex.has_value()) {
+            // Resolved once here, primitives without a texture of their own keep drawing with the last one
+            if (primitive.materialIndex.has_value() && !collisionOnly) {
                 auto& accessor = asset.materials[primitive.materialIndex.value()];
                 if (accessor.pbrData.baseColorTexture.has_value()) {
                     const auto& texture = asset.textures[accessor.pbrData.baseColorTexture.value().textureIndex];
@@ -145,13 +146,13 @@ void ParsedModel::loadModel(const std::filesystem::path& path) {
                         lastIndex = texture.basisuImageIndex.value();
                         globalIndices.emplace_back(globalIndex);
 
-                        Texture modelTexture{};
-                        modelTexture.indexOffset = baseVertices[globalIndex];
-                        this->textures.emplace_back(modelTexture);
+                        this->textures.emplace_back();
                     }
                 }
             }
 
+            this->meshTextures.emplace_back(this->textures.empty() ? NO_TEXTURE : static_cast<uint32_t>(this->textures.size() - 1));
+
             globalIndex++;
         }
     }
@@ -170,7 +171,7 @@ void ParsedModel::loadModel(const std::filesystem::path& path) {
     const auto end = std::chrono::high_resolution_clock::now();
     const std::chrono::duration<double> totalTextureTime = end - start;
 
-    LOGGER.success("LOADED model textures in: ${}", totalTextureTime.count());
+    if (!collisionOnly) LOGGER.success("LOADED model textures in: ${}", totalTextureTime.count());
     LOGGER.success("LOADED model geometry in: ${}", totalGeometryTime);
 }
 
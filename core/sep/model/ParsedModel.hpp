@@ -30,15 +30,19 @@ class ParsedModel {
     glm::vec4 sphere{};
 
     std::vector<Texture> textures{};
+    std::vector<uint32_t> meshTextures{}; // Texture of every mesh, an index into textures or NO_TEXTURE
+
+    static constexpr uint32_t NO_TEXTURE = UINT32_MAX;
 
     ParsedModel() = default;
 
-    explicit ParsedModel(const std::string& path) {
-        loadModel(path);
+    // Collision only skips uvs and textures, enough for headless simulation
+    explicit ParsedModel(const std::string& path, const bool collisionOnly = false) {
+        loadModel(path, collisionOnly);
         calcOcclusionSphere();
     }
 
-    void loadModel(const std::filesystem::path& path);
+    void loadModel(const std::filesystem::path& path, bool collisionOnly = false);
 
     void processImageData(fastgltf::Image& image, fastgltf::Asset& asset, size_t index, size_t textureIndex);
 
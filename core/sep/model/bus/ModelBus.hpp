@@ -11,6 +11,7 @@
 #include "ModelInstance.hpp"
 
 class ParsedModel;
+struct UploadService;
 
 struct ModelBus {
     ModelBus() = default;
@@ -24,7 +25,7 @@ struct ModelBus {
     #pragma region parsedModels
 
 
-    static void loadModelTextures(std::vector<ModelGroup>& groups, const VkDevice& device, const VkCommandPool& commandPool, const VkQueue& graphicsQueue, const VkPhysicalDevice& physicalDevice, VkBuffer& stagingBuffer, VkDeviceMemory& stagingBufferMemory);
+    static void loadModelTextures(std::vector<ModelGroup>& groups, const VkDevice& device, const VkPhysicalDevice& physicalDevice, UploadService& uploads);
 
     static std::shared_ptr<ParsedModel> getModel(std::unordered_map<std::string, ModelGroup>& groups, const std::string& file);
     #pragma endregion
@@ -0,0 +1,62 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_AWAKESET_H
+#define INC_2G43S_AWAKESET_H
+
+#include <cstdint>
+#include <vector>
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/BodyID.h>
+
+// Dense list of bodies that are currently simulated, slot table is indexed by BodyID::GetIndex()
+struct AwakeSet {
+    static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+    std::vector<JPH::BodyID> bodies{};
+    std::vector<uint32_t> slots{};
+
+    void insert(const JPH::BodyID id) {
+        const uint32_t index = id.GetIndex();
+        if (index >= slots.size()) slots.resize(index + 1, INVALID_SLOT);
+        if (slots[index] != INVALID_SLOT) return;
+
+        slots[index] = static_cast<uint32_t>(bodies.size());
+        bodies.emplace_back(id);
+    }
+
+    // Swap remove, order of awake bodies doesn't matter
+    bool erase(const JPH::BodyID id) {
+        const uint32_t index = id.GetIndex();
+        if (index >= slots.size() || slots[index] == INVALID_SLOT) return false;
+
+        const uint32_t slot = slots[index];
+        const JPH::BodyID last = bodies.back();
+
+        bodies[slot] = last;
+        slots[last.GetIndex()] = slot;
+
+        bodies.pop_back();
+        slots[index] = INVALID_SLOT;
+
+        return true;
+    }
+
+    [[nodiscard]] bool contains(const JPH::BodyID id) const {
+        const uint32_t index = id.GetIndex();
+        return index < slots.size() && slots[index] != INVALID_SLOT;
+    }
+
+    [[nodiscard]] size_t size() const {
+        return bodies.size();
+    }
+
+    void clear() {
+        bodies.clear();
+        slots.clear();
+    }
+};
+
+#endif //INC_2G43S_AWAKESET_H
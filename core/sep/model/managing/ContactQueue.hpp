@@ -0,0 +1,169 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_CONTACTQUEUE_H
+#define INC_2G43S_CONTACTQUEUE_H
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/BodyID.h>
+#include <glm/glm.hpp>
+
+struct ContactEvent {
+    enum class Type : uint8_t {
+        Added,
+        Persisted
+    };
+
+    JPH::BodyID body1{};
+    JPH::BodyID body2{};
+
+    glm::vec3 point{};  // World space, on body 1
+    glm::vec3 normal{}; // From body 1 towards body 2
+    float impulse = 0;  // Estimated from approach speed and reduced mass, solver hasn't run yet when jolt reports the contact
+
+    Type type = Type::Added;
+};
+
+enum class ContactOverflowPolicy : uint8_t {
+    DropNewest,   // Reject whatever doesn't fit
+    ShedPersisted // Past the high watermark only added contacts are accepted, so impacts survive a pile of resting contacts
+};
+
+// Bounded lock-free ring (Vyukov MPMC), jolt jobs push and the game thread drains after Update
+struct ContactQueue {
+    explicit ContactQueue(const size_t capacity = 4096, const ContactOverflowPolicy policy = ContactOverflowPolicy::ShedPersisted) :
+    cells(std::make_unique<Cell[]>(std::bit_ceil(capacity))),
+    mask(std::bit_ceil(capacity) - 1),
+    highWatermark(std::bit_ceil(capacity) * 3 / 4),
+    policy(policy) {
+        for (size_t i = 0; i <= mask; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    struct Stats {
+        uint64_t pushed = 0;
+        uint64_t drained = 0;
+        uint64_t dropped = 0; // Queue was full
+        uint64_t shed = 0;    // Persisted contacts rejected by ShedPersisted
+        size_t peak = 0;
+    };
+
+    bool push(const ContactEvent& event) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+
+        if (policy == ContactOverflowPolicy::ShedPersisted && event.type == ContactEvent::Type::Persisted
+            && pos - dequeuePos.load(std::memory_order_relaxed) >= highWatermark) {
+            shed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->event = event;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        pushed.fetch_add(1, std::memory_order_relaxed);
+
+        const size_t used = pos + 1 - dequeuePos.load(std::memory_order_relaxed);
+        size_t currentPeak = peak.load(std::memory_order_relaxed);
+        while (used > currentPeak && !peak.compare_exchange_weak(currentPeak, used, std::memory_order_relaxed)) {}
+
+        return true;
+    }
+
+    bool pop(ContactEvent& event) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        event = cell->event;
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Only drains what was there when called, producers can keep pushing meanwhile
+    size_t drain(const auto& callback) {
+        const size_t available = enqueuePos.load(std::memory_order_acquire) - dequeuePos.load(std::memory_order_relaxed);
+
+        size_t count = 0;
+        ContactEvent event;
+        while (count < available && pop(event)) {
+            callback(event);
+            count++;
+        }
+
+        drained.fetch_add(count, std::memory_order_relaxed);
+        return count;
+    }
+
+    [[nodiscard]] Stats stats() const {
+        return {
+            pushed.load(std::memory_order_relaxed),
+            drained.load(std::memory_order_relaxed),
+            dropped.load(std::memory_order_relaxed),
+            shed.load(std::memory_order_relaxed),
+            peak.load(std::memory_order_relaxed)
+        };
+    }
+
+    [[nodiscard]] size_t capacity() const {
+        return mask + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{};
+        ContactEvent event{};
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    size_t highWatermark;
+    ContactOverflowPolicy policy;
+
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+
+    alignas(64) std::atomic<uint64_t> pushed{0};
+    std::atomic<uint64_t> drained{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> shed{0};
+    std::atomic<size_t> peak{0};
+};
+
+#endif //INC_2G43S_CONTACTQUEUE_H
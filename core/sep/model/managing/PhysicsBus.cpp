@@ -4,7 +4,20 @@
 
 #include "PhysicsBus.hpp"
 
-#include "Engine.hpp"
+#include <Jolt/Physics/Body/BodyLock.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/CollideShape.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+#include <Jolt/Physics/Collision/NarrowPhaseQuery.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/ShapeCast.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <thread>
 
 
 glm::mat4 PhysicsBus::JoltToGlm(const JPH::RMat44 &joltMatrix) {
@@ -41,96 +54,183 @@ void PhysicsBus::initializeJPH() {
 
 	JPH::RegisterTypes();
 
-	temp_allocator = new JPH::TempAllocatorImpl (ALLOCATOR_SIZE);
-	job_system = new JPH::JobSystemThreadPool(MAX_JOBS, MAX_BARRIERS, std::thread::hardware_concurrency() - 1); // Init multithreaded jobs system
+	// Every world updating at the same time holds barriers, so MAX_BARRIERS limits how many worlds step in parallel
+	job_system = new JPH::JobSystemThreadPool(MAX_JOBS, MAX_BARRIERS, THREADS < 0 ? static_cast<int>(std::thread::hardware_concurrency()) - 1 : THREADS); // Init multithreaded jobs system
 
-	physics_system = new JPH::PhysicsSystem();
+	addWorld(DEFAULT_WORLD);
+}
+
+uint32_t PhysicsBus::addWorld(const PhysicsWorldSettings& settings) {
+	worlds.emplace_back().initialize(settings);
+	return static_cast<uint32_t>(worlds.size() - 1);
+}
 
-	// Physics parameters
-	constexpr uint cMaxBodies = 1024;
-	constexpr uint cMaxBodyPairs = 2048;
-	constexpr uint cMaxContactConstraints = 1024;
-	constexpr uint cNumBodyMutexes = 0;
+void PhysicsBus::step() {
+	const uint64_t next = tick + 1;
 
-	// Create mapping table from object layer to broadphase layer
-	// Note: As this is an interface, PhysicsSystem will take a reference to this so this instance needs to stay alive!
-	// Also have a look at BroadPhaseLayerInterfaceTable or BroadPhaseLayerInterfaceMask for a simpler interface.
-	bp_interface = new BPLayerInterfaceImpl();
+	{
+		std::unique_lock lock(bodyMutex);
+
+		// Worlds don't share anything but the job system, which is fine with several Update calls at once
+		#pragma omp parallel for schedule(dynamic, 1) if(worlds.size() > 1)
+		for (size_t i = 0; i < worlds.size(); ++i) {
+			PhysicsWorld& world = worlds[i];
+			world.update(cDeltaTime, stepper, job_system);
+			world.history.capture(next, *world.physics_system, world.awakeBodies, world.frozenBodies);
+		}
+	}
 
-	// Create class that filters object vs broadphase layers
-	// Note: As this is an interface, PhysicsSystem will take a reference to this so this instance needs to stay alive!
-	// Also have a look at ObjectVsBroadPhaseLayerFilterTable or ObjectVsBroadPhaseLayerFilterMask for a simpler interface.
-	obj_bp_filter = new ObjectVsBroadPhaseLayerFilterImpl();
+	tick = next;
 
-	// Create class that filters object vs object layers
-	// Note: As this is an interface, PhysicsSystem will take a reference to this so this instance needs to stay alive!
-	// Also have a look at ObjectLayerPairFilterTable or ObjectLayerPairFilterMask for a simpler interface.
-	obj_obj_filter = new ObjectLayerPairFilterImpl();
+	// Contact callbacks always run on the calling thread
+	for (uint32_t i = 0; i < worlds.size(); ++i) {
+		drainContacts(i);
+	}
 
-	// Now we can create the actual physics system.
-	physics_system->Init(cMaxBodies, cNumBodyMutexes, cMaxBodyPairs, cMaxContactConstraints, *bp_interface, *obj_bp_filter, *obj_obj_filter);
+	if (lod.enabled && tick % lod.interval == 0) {
+		std::unique_lock lock(bodyMutex);
+		for (auto& world : worlds) {
+			world.updateLod(lod);
+		}
+	}
+}
 
-	// A body activation listener gets notified when bodies activate and go to sleep
-	// Note that this is called from a job so whatever you do here needs to be thread safe.
-	// Registering one is entirely optional.
-	body_activation_listener = new MyBodyActivationListener();
-	physics_system->SetBodyActivationListener(body_activation_listener);
+uint32_t PhysicsBus::advance(const double elapsed) {
+	for (auto& world : worlds) {
+		world.frozenBodies.clear();
+	}
+	stepper.accumulator += elapsed;
 
-	// A contact listener gets notified when bodies (are about to) collide, and when they separate again.
-	// Note that this is called from a job so whatever you do here needs to be thread safe.
-	// Registering one is entirely optional.
-	contact_listener = new MyContactListener();
-	physics_system->SetContactListener(contact_listener);
+	const auto start = std::chrono::steady_clock::now();
+	uint32_t ticks = 0;
 
-	// The main way to interact with the bodies in the physics system is through the body interface. There is a locking and a non-locking
-	// variant of this. We're going to use the locking version (even though we're not planning to access bodies from multiple threads)
+	while (stepper.accumulator >= cDeltaTime && ticks < stepper.maxCatchUpTicks) {
+		// Always do at least one tick, otherwise a slow frame would stall the world completely
+		if (ticks > 0 && std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() > stepper.budgetMs) break;
 
-	physics_system->SetGravity(JPH::Vec3(0.0f, 0.0f, -13.8f));
+		step();
+		stepper.accumulator -= cDeltaTime;
+		ticks++;
+	}
+
+	// Backlog we can't ever catch up is dropped, the world runs slower instead of spiraling
+	if (const double backlog = stepper.maxCatchUpTicks * static_cast<double>(cDeltaTime); stepper.accumulator > backlog) {
+		stepper.droppedTime += stepper.accumulator - backlog;
+		stepper.accumulator = backlog;
+	}
+
+	if (stepper.droppedTime - stepper.reportedDropped >= 1.0) {
+		LOGGER.warn("Physics is behind, dropped ${} seconds of simulation so far", stepper.droppedTime);
+		stepper.reportedDropped = stepper.droppedTime;
+	}
+
+	stepper.lastTicks = ticks;
+	return ticks;
 }
 
-void PhysicsBus::iterateJPH(Engine& engine) const {
-	// ШАГ 1: Обновляем физический мир (ОДИН РАЗ за вызов функции)
-	// 1 — это количество подшагов (collision steps)
-	physics_system->Update(cDeltaTime, 4, temp_allocator, job_system);
+void PhysicsBus::iterateJPH(const double elapsed) {
+	{
+		std::lock_guard lock(streamMutex);
+		lod.focus = streamFocus;
+	}
 
-	// ШАГ 2: Получаем активные тела для синхронизации графики
-	JPH::BodyIDVector activeBodies;
-	physics_system->GetActiveBodies(JPH::EBodyType::RigidBody, activeBodies);
+	if (advance(elapsed) == 0) return;
 
-	const JPH::BodyInterface &body_interface = physics_system->GetBodyInterface();
+	std::vector<StreamedTransform> transforms{};
+	for (uint32_t w = 0; w < worlds.size(); ++w) {
+		const PhysicsWorld& world = worlds[w];
 
-	for (JPH::BodyID id : activeBodies) {
-		// Используем GetWorldTransform без лока, так как мы сейчас в одном потоке
-		// и Update уже завершен. Это быстрее и безопаснее.
-		JPH::RMat44 transform = body_interface.GetWorldTransform(id);
+		// Locking interface, the render thread may be adding bodies meanwhile
+		const JPH::BodyInterface &body_interface = world.physics_system->GetBodyInterface();
 
-		auto it = engine.modelEntityManager.bodyID.find(id);
-		if (it != engine.modelEntityManager.bodyID.end()) {
-			auto& data = it->second;
-			engine.bufferManager.updateSingleModel(data.first, data.second, JoltToGlm(transform));
+		auto publish = [&](const JPH::BodyID id, const bool frozen) {
+			JPH::RVec3 position;
+			JPH::Quat rotation;
+			body_interface.GetPositionAndRotation(id, position, rotation);
+
+			transforms.push_back({
+				w, id, frozen,
+				glm::vec4(position.GetX(), position.GetY(), position.GetZ(), 0.0f),
+				glm::vec4(rotation.GetX(), rotation.GetY(), rotation.GetZ(), rotation.GetW()),
+				JoltToGlm(body_interface.GetWorldTransform(id))
+			});
+		};
+
+		// Awake bodies are streamed every tick, the reduced LOD band every few ticks (staggered by id)
+		for (const JPH::BodyID id : world.awakeBodies.bodies) {
+			if (lod.enabled && world.inReducedBand(id) && (tick + id.GetIndex()) % lod.reducedStreamInterval != 0) continue;
+			publish(id, false);
+		}
+
+		for (const JPH::BodyID id : world.frozenBodies) {
+			publish(id, true);
 		}
 	}
+
+	std::lock_guard lock(streamMutex);
+	streamed.insert(streamed.end(), transforms.begin(), transforms.end());
 }
 
-void PhysicsBus::shutdownJPH() const {
-	JPH::BodyInterface &body_interface = physics_system->GetBodyInterface();
+bool PhysicsBus::rewind(const uint32_t ticks, const bool resimulate) {
+	if (ticks == 0) return true;
+	if (ticks > tick) return false;
 
-	JPH::BodyIDVector bodies;
-	physics_system->GetBodies(bodies);
+	const uint64_t target = tick - ticks;
+	for (const auto& world : worlds) {
+		if (world.history.restoreStart(target) == PhysicsHistory::INVALID_TICK) return false;
+	}
+
+	{
+		std::unique_lock lock(bodyMutex);
+		for (auto& world : worlds) {
+			world.history.restore(target, *world.physics_system, world.frozenBodies);
+			world.updateAwakeSet();
+		}
+	}
+	tick = target;
+
+	if (!resimulate) return true;
+
+	for (uint32_t i = 0; i < ticks; ++i) {
+		if (onResimulate) onResimulate(tick + 1);
+		step();
+	}
+
+	return true;
+}
+
+void PhysicsBus::drainContacts(const uint32_t index) {
+	PhysicsWorld& world = worlds[index];
 
-	for (JPH::BodyID id : bodies) {
-		body_interface.RemoveBody(id);
-		body_interface.DestroyBody(id);
+	world.contact_queue->drain([this, index](const ContactEvent& event) {
+		if (onContact) onContact(index, event);
+	});
+
+	const auto stats = world.contact_queue->stats();
+	if (const uint64_t lost = stats.dropped + stats.shed; lost > world.reportedContactLoss) {
+		LOGGER.warn("Contact queue of world ${} lost ${} events (${} dropped, ${} shed, peak ${}/${})", index, lost - world.reportedContactLoss, stats.dropped, stats.shed, stats.peak, world.contact_queue->capacity());
+		world.reportedContactLoss = lost;
+	}
+}
+
+size_t PhysicsBus::getAwakeBodyCount() const {
+	size_t count = 0;
+	for (const auto& world : worlds) {
+		count += world.awakeBodies.size();
 	}
+	return count;
+}
+
+void PhysicsBus::shutdownJPH() {
+	for (auto& world : worlds) {
+		world.shutdown();
+	}
+	worlds.clear();
 
-	delete physics_system;
-	delete bp_interface;
-	delete obj_bp_filter;
-	delete obj_obj_filter;
-	delete temp_allocator;
 	delete job_system;
-	delete body_activation_listener;
-	delete contact_listener;
+
+	tick = 0;
+	stepper.accumulator = 0;
 
 	JPH::UnregisterTypes();
 
@@ -140,13 +240,149 @@ void PhysicsBus::shutdownJPH() const {
 #pragma endregion
 
 #pragma region Body
-JPH::BodyID PhysicsBus::createBody(JPH::BodyCreationSettings body_settings) const {
-	JPH::BodyInterface &body_interface = physics_system->GetBodyInterface();
+uint32_t PhysicsBus::routeWorld(const glm::vec3& pos) const {
+	for (uint32_t i = 1; i < worlds.size(); ++i) {
+		if (worlds[i].contains(pos)) return i;
+	}
+	return 0;
+}
+
+PhysicsHandle PhysicsBus::createBody(const JPH::BodyCreationSettings& body_settings) const {
+	const JPH::RVec3 pos = body_settings.mPosition;
+	return createBody(body_settings, routeWorld(glm::vec3(pos.GetX(), pos.GetY(), pos.GetZ())));
+}
+
+PhysicsHandle PhysicsBus::createBody(JPH::BodyCreationSettings body_settings, const uint32_t world) const {
+	std::shared_lock lock(bodyMutex);
+	JPH::BodyInterface &body_interface = worlds[world].physics_system->GetBodyInterface();
 
 	body_settings.mEnhancedInternalEdgeRemoval = true;
 	body_settings.mMotionQuality = JPH::EMotionQuality::LinearCast;
 	body_settings.mUserData = 1;
 
-	return body_interface.CreateAndAddBody(body_settings, JPH::EActivation::Activate);
+	return {world, body_interface.CreateAndAddBody(body_settings, JPH::EActivation::Activate)};
+}
+#pragma endregion
+
+
+#pragma region Query
+static glm::vec3 toGlm(const JPH::Vec3 vec) {
+	return {vec.GetX(), vec.GetY(), vec.GetZ()};
 }
-#pragma endregion
\ No newline at end of file
+
+static JPH::Vec3 toJolt(const glm::vec3 vec) {
+	return {vec.x, vec.y, vec.z};
+}
+
+static void castRay(const JPH::PhysicsSystem& physics_system, const RayQuery& query, SceneQueryResults& results, const size_t queryIndex) {
+	const JPH::RRayCast ray{JPH::RVec3(toJolt(query.origin)), toJolt(query.direction)};
+
+	JPH::RayCastResult hit;
+	if (!physics_system.GetNarrowPhaseQueryNoLock().CastRay(ray, hit)) return;
+
+	const uint32_t slot = results.firstHit[queryIndex];
+	const JPH::RVec3 point = ray.GetPointOnRay(hit.mFraction);
+
+	results.body[slot] = hit.mBodyID;
+	results.fraction[slot] = hit.mFraction;
+	results.point[slot] = glm::vec3(point.GetX(), point.GetY(), point.GetZ());
+
+	// Ray hits don't carry a normal, ask the shape for it
+	const JPH::BodyLockRead lock(physics_system.GetBodyLockInterfaceNoLock(), hit.mBodyID);
+	results.normal[slot] = lock.Succeeded() ? toGlm(lock.GetBody().GetWorldSpaceSurfaceNormal(hit.mSubShapeID2, point)) : -glm::normalize(query.direction);
+
+	results.hitCount[queryIndex] = 1;
+}
+
+static void castSphere(const JPH::PhysicsSystem& physics_system, const SphereCastQuery& query, SceneQueryResults& results, const size_t queryIndex) {
+	JPH::SphereShape sphere(query.radius);
+	sphere.SetEmbedded();
+
+	const JPH::RShapeCast cast(&sphere, JPH::Vec3::sOne(), JPH::RMat44::sTranslation(JPH::RVec3(toJolt(query.origin))), toJolt(query.direction));
+
+	JPH::ClosestHitCollisionCollector<JPH::CastShapeCollector> collector;
+	physics_system.GetNarrowPhaseQueryNoLock().CastShape(cast, JPH::ShapeCastSettings(), JPH::RVec3::sZero(), collector);
+	if (!collector.HadHit()) return;
+
+	const uint32_t slot = results.firstHit[queryIndex];
+	const JPH::ShapeCastResult& hit = collector.mHit;
+
+	results.body[slot] = hit.mBodyID2;
+	results.fraction[slot] = hit.mFraction;
+	results.point[slot] = toGlm(hit.mContactPointOn2);
+	results.normal[slot] = toGlm(-hit.mPenetrationAxis.NormalizedOr(JPH::Vec3::sZero()));
+
+	results.hitCount[queryIndex] = 1;
+}
+
+static void overlapSphere(const JPH::PhysicsSystem& physics_system, const OverlapQuery& query, const uint32_t maxHits, SceneQueryResults& results, const size_t queryIndex) {
+	JPH::SphereShape sphere(query.radius);
+	sphere.SetEmbedded();
+
+	JPH::AllHitCollisionCollector<JPH::CollideShapeCollector> collector;
+	physics_system.GetNarrowPhaseQueryNoLock().CollideShape(&sphere, JPH::Vec3::sOne(), JPH::RMat44::sTranslation(JPH::RVec3(toJolt(query.center))), JPH::CollideShapeSettings(), JPH::RVec3::sZero(), collector);
+
+	const uint32_t first = results.firstHit[queryIndex];
+	uint32_t count = 0;
+
+	// Meshes report a hit per triangle, keep only the deepest one per body
+	for (const JPH::CollideShapeResult& hit : collector.mHits) {
+		uint32_t slot = first;
+		while (slot < first + count && results.body[slot] != hit.mBodyID2) slot++;
+
+		if (slot == first + count) {
+			if (count == maxHits) continue;
+			count++;
+		} else if (results.fraction[slot] >= hit.mPenetrationDepth) {
+			continue;
+		}
+
+		results.body[slot] = hit.mBodyID2;
+		results.fraction[slot] = hit.mPenetrationDepth;
+		results.point[slot] = toGlm(hit.mContactPointOn2);
+		results.normal[slot] = toGlm(-hit.mPenetrationAxis.NormalizedOr(JPH::Vec3::sZero()));
+	}
+
+	results.hitCount[queryIndex] = count;
+}
+
+void PhysicsBus::queryBatch(const SceneQueryBatch& batch, SceneQueryResults& results, const uint32_t world) const {
+	results.prepare(batch);
+
+	const JPH::PhysicsSystem* physics_system = worlds[world].physics_system;
+
+	const size_t total = batch.size();
+	if (total == 0) return;
+
+	auto run = [physics_system, &batch, &results](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			if (i < results.sphereCastOffset) {
+				castRay(*physics_system, batch.rays[i], results, i);
+			} else if (i < results.overlapOffset) {
+				castSphere(*physics_system, batch.sphereCasts[i - results.sphereCastOffset], results, i);
+			} else {
+				overlapSphere(*physics_system, batch.overlaps[i - results.overlapOffset], batch.maxOverlapHits, results, i);
+			}
+		}
+	};
+
+	// Not worth waking the workers
+	if (total <= QUERY_JOB_SIZE) {
+		run(0, total);
+		return;
+	}
+
+	std::vector<JPH::JobHandle> jobs{};
+	jobs.reserve((total + QUERY_JOB_SIZE - 1) / QUERY_JOB_SIZE);
+
+	for (size_t begin = 0; begin < total; begin += QUERY_JOB_SIZE) {
+		const size_t end = std::min<size_t>(begin + QUERY_JOB_SIZE, total);
+		jobs.emplace_back(job_system->CreateJob("SceneQuery", JPH::Color::sCyan, [&run, begin, end] { run(begin, end); }));
+	}
+
+	JPH::JobSystem::Barrier* barrier = job_system->CreateBarrier();
+	barrier->AddJobs(jobs.data(), static_cast<JPH::uint>(jobs.size()));
+	job_system->WaitForJobs(barrier);
+	job_system->DestroyBarrier(barrier);
+}
+#pragma endregion
@@ -20,13 +20,23 @@
 #include <Jolt/Physics/Collision/Shape/SphereShape.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Body/BodyActivationListener.h>
-
+#include <Jolt/Physics/Body/Body.h>
+
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include "AwakeSet.hpp"
+#include "ContactQueue.hpp"
+#include "PhysicsHistory.hpp"
+#include "SceneQuery.hpp"
 #include "Logger.hpp"
 #define GLM_FORCE_RADIANS
-#include <imgui_impl_sdl3.h>
 #include <glm/glm.hpp>
-
-#include "ModelGroup.hpp"
 #pragma endregion
 
 #pragma region Generic
@@ -114,6 +124,8 @@ public:
 class MyContactListener final : public JPH::ContactListener {
     Logger LOGGER = Logger("ContactListener");
 public:
+    explicit MyContactListener(ContactQueue* queue) : queue(queue) {}
+
     // See: ContactListener
     JPH::ValidateResult	OnContactValidate(const JPH::Body &inBody1, const JPH::Body &inBody2, JPH::RVec3Arg inBaseOffset, const JPH::CollideShapeResult &inCollisionResult) override {
         //logger.info("Contact validate callback");
@@ -122,51 +134,170 @@ public:
     }
 
     void OnContactAdded(const JPH::Body &inBody1, const JPH::Body &inBody2, const JPH::ContactManifold &inManifold, JPH::ContactSettings &ioSettings) override {
-        //logger.info("A contact was added");
+        trackPenetration(inManifold.mPenetrationDepth);
+        queue->push(record(inBody1, inBody2, inManifold, ContactEvent::Type::Added));
     }
 
     void OnContactPersisted(const JPH::Body &inBody1, const JPH::Body &inBody2, const JPH::ContactManifold &inManifold, JPH::ContactSettings &ioSettings) override {
-        //logger.info("A contact was persisted");
+        trackPenetration(inManifold.mPenetrationDepth);
+        queue->push(record(inBody1, inBody2, inManifold, ContactEvent::Type::Persisted));
     }
 
     void OnContactRemoved(const JPH::SubShapeIDPair &inSubShapePair) override {
         //logger.info("A contact was removed");
     }
+
+    // Deepest penetration seen since the last call
+    float takeMaxPenetration() {
+        return maxPenetration.exchange(0.0f, std::memory_order_relaxed);
+    }
+
+private:
+    ContactQueue* queue;
+    std::atomic<float> maxPenetration{0.0f};
+
+    void trackPenetration(const float depth) {
+        float current = maxPenetration.load(std::memory_order_relaxed);
+        while (depth > current && !maxPenetration.compare_exchange_weak(current, depth, std::memory_order_relaxed)) {}
+    }
+
+    static float inverseMass(const JPH::Body& body) {
+        return body.IsDynamic() ? body.GetMotionProperties()->GetInverseMass() : 0.0f;
+    }
+
+    static ContactEvent record(const JPH::Body &inBody1, const JPH::Body &inBody2, const JPH::ContactManifold &inManifold, const ContactEvent::Type type) {
+        const JPH::RVec3 point = inManifold.GetWorldSpaceContactPointOn1(0);
+        const JPH::Vec3 normal = inManifold.mWorldSpaceNormal;
+
+        // Impulse needed to stop the approach along the normal
+        const float approach = (inBody1.GetPointVelocity(point) - inBody2.GetPointVelocity(point)).Dot(normal);
+        const float inverseMassSum = inverseMass(inBody1) + inverseMass(inBody2);
+        const float impulse = approach > 0.0f && inverseMassSum > 0.0f ? approach / inverseMassSum : 0.0f;
+
+        return {
+            inBody1.GetID(), inBody2.GetID(),
+            glm::vec3(point.GetX(), point.GetY(), point.GetZ()),
+            glm::vec3(normal.GetX(), normal.GetY(), normal.GetZ()),
+            impulse, type
+        };
+    }
 };
 
-// An example activation listener
+// Called from jobs, so events are only queued here and folded into the awake set after Update
 class MyBodyActivationListener final : public JPH::BodyActivationListener {
     Logger LOGGER = Logger("BodyActivationListener");
 public:
+    struct Event {
+        JPH::BodyID id;
+        bool awake;
+    };
+
     void OnBodyActivated(const JPH::BodyID &inBodyID, JPH::uint64 inBodyUserData) override {
-        //logger.info("A body got activated");
+        std::lock_guard lock(mutex);
+        events.emplace_back(inBodyID, true);
     }
 
     void OnBodyDeactivated(const JPH::BodyID &inBodyID, JPH::uint64 inBodyUserData) override {
-        //logger.info("A body went to sleep");
+        std::lock_guard lock(mutex);
+        events.emplace_back(inBodyID, false);
+    }
+
+    // Hands over everything queued since the last call, keeps both vectors capacity
+    void drain(std::vector<Event>& out) {
+        out.clear();
+
+        std::lock_guard lock(mutex);
+        out.swap(events);
     }
+
+private:
+    std::mutex mutex;
+    std::vector<Event> events{};
 };
 
 #pragma endregion
 
 
 
-struct PhysicsBus {
-    #pragma region Parameters
-    uint ALLOCATOR_SIZE = 10 * 1024 * 1024; // 10 MB
-    uint MAX_JOBS = 4096;
-    uint MAX_BARRIERS = 16;
+// Pose of a body after a tick, handed from the tick thread to the render thread
+struct StreamedTransform {
+    uint32_t world;
+    JPH::BodyID id;
+    bool frozen; // Fell asleep this tick, its resting pose is written back to the instance
+    glm::vec4 pos;
+    glm::vec4 rot;
+    glm::mat4 matrix;
+};
 
-    uint TICK_RATE = 256;
-    float cDeltaTime = 1.0f / TICK_RATE;
-    #pragma endregion
+// Distance based physics LOD around a focus point (camera or region of interest)
+struct PhysicsLod {
+    bool enabled = true;
+    glm::vec3 focus{};
+
+    float reducedRadius = 64.0f; // Past this bodies drop continuous collision and stream transforms at a reduced rate
+    float sleepRadius = 160.0f;  // Past this bodies are put to sleep
+    float wakeMargin = 8.0f;     // Forced sleepers wake once back inside sleepRadius - wakeMargin
+
+    uint32_t interval = 16;             // Ticks between LOD passes
+    uint32_t reducedStreamInterval = 4; // Reduced band uploads every Nth tick
+};
+
+// Accumulator stepper, collision steps follow how fast things move and how deep they sink into each other
+struct PhysicsStepper {
+    uint32_t maxCatchUpTicks = 8; // Ticks per advance() call, also the most backlog that is kept
+    double budgetMs = 4.0;        // Wall clock spent stepping per advance() call
+
+    int minCollisionSteps = 1;
+    int maxCollisionSteps = 4;
+    float maxTravelPerStep = 0.25f; // Meters the fastest body may move per collision step
+    float penetrationSlop = 0.05f;  // Deeper penetration than this adds a collision step
+
+    // State
+    double accumulator = 0;
+
+    // Stats
+    double droppedTime = 0;   // Total simulation seconds thrown away
+    double reportedDropped = 0;
+    uint32_t lastTicks = 0;
+};
+
+struct PhysicsWorldSettings {
+    uint maxBodies = 1024;
+    uint maxBodyPairs = 2048;
+    uint maxContactConstraints = 1024;
+    uint allocatorSize = 10 * 1024 * 1024; // 10 MB, every world gets its own so they can step at the same time
 
-    std::vector<JPH::BodyID> physicsBodies{};
+    size_t contactQueueSize = 8192;
+    ContactOverflowPolicy contactOverflowPolicy = ContactOverflowPolicy::ShedPersisted;
+
+    glm::vec3 gravity{0.0f, 0.0f, -13.8f};
+
+    uint historyTicks = 256;           // Rewind window, one second at 256 Hz. 0 disables capture
+    uint historyKeyframeInterval = 32; // Full snapshots every N ticks, in between only awake bodies
+
+    // Spawns inside these bounds are routed to this world, world 0 takes whatever nobody claims
+    glm::vec3 boundsMin{-INFINITY};
+    glm::vec3 boundsMax{INFINITY};
+
+    // Own layer setup, defaults (Layers::NON_MOVING / MOVING) are used when left null. Must outlive the world
+    const JPH::BroadPhaseLayerInterface* bpInterface{};
+    const JPH::ObjectVsBroadPhaseLayerFilter* objBpFilter{};
+    const JPH::ObjectLayerPairFilter* objObjFilter{};
+};
+
+struct PhysicsHandle {
+    uint32_t world = 0;
+    JPH::BodyID id{};
+};
+
+// One independent PhysicsSystem with its own limits, layers, listeners and awake set
+struct PhysicsWorld {
+    PhysicsWorldSettings settings{};
 
     JPH::TempAllocatorImpl* temp_allocator{};
-    JPH::JobSystemThreadPool* job_system{};
     JPH::PhysicsSystem* physics_system{};
 
+    // Default layer setup, only created when settings don't bring their own
     BPLayerInterfaceImpl* bp_interface{};
     ObjectVsBroadPhaseLayerFilterImpl* obj_bp_filter{};
     ObjectLayerPairFilterImpl* obj_obj_filter{};
@@ -174,25 +305,139 @@ struct PhysicsBus {
     MyBodyActivationListener* body_activation_listener{};
     MyContactListener* contact_listener{};
 
+    // Filled by jolt jobs during Update, drained on the game thread right after it
+    ContactQueue* contact_queue{};
+    uint64_t reportedContactLoss = 0;
+
+    // Only awake bodies get their transforms streamed to the gpu
+    AwakeSet awakeBodies{};
+    std::vector<JPH::BodyID> frozenBodies{};
+    std::vector<MyBodyActivationListener::Event> activationEvents{};
+
+    std::vector<uint8_t> reducedBand{}; // Indexed by BodyID::GetIndex()
+    std::vector<JPH::BodyID> lodSleeping{};
+
+    PhysicsHistory history{};
+
+    // Last tick statistics feeding the stepper
+    float maxSpeed = 0;
+    float maxPenetration = 0;
+    int collisionSteps = 1;
+
+    void initialize(const PhysicsWorldSettings& worldSettings);
+
+    // Update plus awake set and statistics, safe to run for several worlds at once
+    void update(float deltaTime, const PhysicsStepper& stepper, JPH::JobSystem* job_system);
+
+    int chooseCollisionSteps(float deltaTime, const PhysicsStepper& stepper);
+
+    // Folds queued activation events into awakeBodies, bodies that fell asleep land in frozenBodies (cleared by PhysicsBus::advance)
+    void updateAwakeSet();
+
+    // Puts far bodies to sleep, wakes them when the focus comes back and switches motion quality per band
+    void updateLod(const PhysicsLod& lod);
+
+    [[nodiscard]] bool inReducedBand(JPH::BodyID id) const;
+
+    [[nodiscard]] bool contains(const glm::vec3& pos) const;
+
+    void shutdown();
+};
+
+struct PhysicsBus {
+    #pragma region Parameters
+    uint MAX_JOBS = 4096;
+    uint MAX_BARRIERS = 16;
+    int THREADS = -1; // Worker threads of the job system, -1 for all cores but one
+
+    PhysicsWorldSettings DEFAULT_WORLD{}; // Settings of world 0
+
+    PhysicsLod lod{};
+    PhysicsStepper stepper{};
+
+    uint QUERY_JOB_SIZE = 64; // Queries per job in queryBatch
+
+    uint TICK_RATE = 256;
+    float cDeltaTime = 1.0f / TICK_RATE;
+    #pragma endregion
+
+    // Worlds share the job system and are stepped concurrently
+    std::vector<PhysicsWorld> worlds{};
+    JPH::JobSystemThreadPool* job_system{};
+
+    uint64_t tick = 0;
+
+    std::function<void(uint32_t world, const ContactEvent&)> onContact{};
+    std::function<void(uint64_t tick)> onResimulate{}; // Called before each resimulated tick to replay inputs
+
     std::unordered_map<std::string, JPH::ShapeRefC> collisionHulls{};
     std::unordered_map<std::string, JPH::ShapeRefC> collisionMeshes{};
 
+    // Stepping holds it exclusively and body creation shared, Jolt doesn't allow adding bodies during an update
+    mutable std::shared_mutex bodyMutex{};
+
+    // Filled by iterateJPH on the tick thread, drained by syncJPH on the render thread.
+    // Transforms are applied in order, so the newest pose of a body wins
+    std::mutex streamMutex{};
+    std::vector<StreamedTransform> streamed{};
+    glm::vec3 streamFocus{}; // Camera position for lod.focus, which only the tick thread touches
+
+    Logger LOGGER{"PhysicsBus"};
+
     static glm::mat4 JoltToGlm(const JPH::RMat44 &joltMatrix);
 
     #pragma region Main
     void initializeJPH();
 
-    void iterateJPH(Engine& engine) const;
+    // Adds another world after initializeJPH, returns its index
+    uint32_t addWorld(const PhysicsWorldSettings& settings);
+
+    PhysicsWorld& world(const uint32_t index = 0) {
+        return worlds[index];
+    }
+
+    // Pure simulation step of every world, doesn't touch the renderer
+    void step();
+
+    // Steps as many ticks as elapsed wall time allows within the stepper budget, returns ticks stepped
+    uint32_t advance(double elapsed);
 
-    void shutdownJPH() const;
+    // Tick thread: advances and publishes the poses of awake and just frozen bodies into streamed
+    void iterateJPH(double elapsed);
+
+    // Render thread: applies the published poses to the instances and their buffers (PhysicsBusSync.cpp)
+    void syncJPH(Engine& engine);
+
+    // Restores every world to the state ticks ago and steps back to the current tick when resimulate is set.
+    // Fails without touching anything when some world's history doesn't reach back that far
+    bool rewind(uint32_t ticks, bool resimulate = true);
+
+    void drainContacts(uint32_t index);
+
+    [[nodiscard]] size_t getAwakeBodyCount() const;
+
+    void shutdownJPH();
     #pragma endregion
 
 
 
     #pragma region Body
-    JPH::BodyID createBody(JPH::BodyCreationSettings body_settings) const;
+    // World whose bounds contain pos, 0 when none does
+    [[nodiscard]] uint32_t routeWorld(const glm::vec3& pos) const;
+
+    // Routed by spawn position
+    PhysicsHandle createBody(const JPH::BodyCreationSettings& body_settings) const;
+
+    PhysicsHandle createBody(JPH::BodyCreationSettings body_settings, uint32_t world) const;
+    #pragma endregion
+
+
+
+    #pragma region Query
+    // Runs the whole batch on the job system, call between steps since it uses the no lock query interfaces
+    void queryBatch(const SceneQueryBatch& batch, SceneQueryResults& results, uint32_t world = 0) const;
     #pragma endregion
 };
 
 
-#endif //INC_2G43S_PHYSICSBUS_H
\ No newline at end of file
+#endif //INC_2G43S_PHYSICSBUS_H
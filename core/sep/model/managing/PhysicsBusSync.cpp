@@ -0,0 +1,44 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+// Bridge between the simulation and the renderer, kept out of PhysicsBus.cpp so it builds without Vulkan and SDL
+
+#include "PhysicsBus.hpp"
+
+#include "Engine.hpp"
+
+#pragma region Main
+void PhysicsBus::syncJPH(Engine& engine) {
+	std::vector<StreamedTransform> transforms{};
+	{
+		std::lock_guard lock(streamMutex);
+		streamFocus = engine.camera.pos;
+		transforms.swap(streamed);
+	}
+	if (transforms.empty()) return;
+
+	auto& modelEntityManager = engine.modelEntityManager;
+	std::lock_guard lock(modelEntityManager.bodyID_mutex);
+
+	for (const StreamedTransform& transform : transforms) {
+		if (transform.world >= modelEntityManager.bodyID.size()) continue;
+
+		const auto& bodies = modelEntityManager.bodyID[transform.world];
+		const auto it = bodies.find(transform.id);
+		if (it == bodies.end()) continue;
+
+		const auto& [file, index] = it->second;
+
+		// Bodies that just fell asleep write their resting pose back to the instance,
+		// so a full model data rebuild reproduces the frozen matrix instead of the spawn pose
+		if (transform.frozen) {
+			auto& instance = modelEntityManager.groups[modelEntityManager.indices[file]].instances[index];
+			instance.pos = glm::vec4(glm::vec3(transform.pos), instance.pos.w);
+			instance.rot = transform.rot;
+		}
+
+		engine.bufferManager.updateSingleModel(file, index, transform.matrix);
+	}
+}
+#pragma endregion
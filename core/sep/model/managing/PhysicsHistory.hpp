@@ -0,0 +1,217 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_PHYSICSHISTORY_H
+#define INC_2G43S_PHYSICSHISTORY_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Body/BodyInterface.h>
+
+#include "AwakeSet.hpp"
+
+// Ring of per-tick SoA snapshots. Every tick stores only the awake bodies (sleeping ones don't move),
+// keyframes additionally store every sleeping dynamic body so a restore has a full starting point.
+// Restoring replays the frames from the nearest keyframe up to the target tick.
+// Not restored: contact cache, sleep timers and bodies added after the keyframe, so resimulation is close but not bit exact
+struct PhysicsHistory {
+    static constexpr uint64_t INVALID_TICK = UINT64_MAX;
+    static constexpr size_t BYTES_PER_BODY = sizeof(JPH::BodyID) + sizeof(JPH::Float3) * 3 + sizeof(JPH::Float4); // 56
+
+    struct Frame {
+        uint64_t tick = INVALID_TICK;
+        bool keyframe = false;
+        uint32_t awakeCount = 0; // Bodies past this were asleep at tick (keyframes and bodies that just fell asleep)
+
+        std::vector<JPH::BodyID> bodies{};
+        std::vector<JPH::Float3> position{};
+        std::vector<JPH::Float4> rotation{};
+        std::vector<JPH::Float3> linearVelocity{};
+        std::vector<JPH::Float3> angularVelocity{};
+
+        void clear() {
+            awakeCount = 0;
+            bodies.clear();
+            position.clear();
+            rotation.clear();
+            linearVelocity.clear();
+            angularVelocity.clear();
+        }
+
+        [[nodiscard]] size_t bytes() const {
+            return bodies.size() * BYTES_PER_BODY;
+        }
+    };
+
+    struct Stats {
+        double lastCaptureUs = 0;
+        double peakCaptureUs = 0;
+        size_t lastBytes = 0;
+        size_t peakBytes = 0;
+    };
+
+    std::vector<Frame> frames{};
+    uint32_t keyframeInterval = 32;
+
+    uint64_t latest = INVALID_TICK;
+    uint64_t lastKeyframe = INVALID_TICK;
+
+    Stats stats{};
+
+    void initialize(const uint32_t ticks, const uint32_t interval) {
+        frames.assign(ticks, Frame{});
+        keyframeInterval = interval;
+        latest = INVALID_TICK;
+        lastKeyframe = INVALID_TICK;
+    }
+
+    [[nodiscard]] bool enabled() const {
+        return !frames.empty();
+    }
+
+    [[nodiscard]] const Frame& frame(const uint64_t tick) const {
+        return frames[tick % frames.size()];
+    }
+
+    // State after the tick was stepped, call between steps
+    void capture(const uint64_t tick, const JPH::PhysicsSystem& system, const AwakeSet& awake, const std::vector<JPH::BodyID>& frozen) {
+        if (!enabled()) return;
+
+        const auto start = std::chrono::steady_clock::now();
+        const JPH::BodyInterface &body_interface = system.GetBodyInterfaceNoLock();
+
+        Frame& frame = frames[tick % frames.size()];
+        frame.clear();
+        frame.tick = tick;
+        frame.keyframe = lastKeyframe == INVALID_TICK || lastKeyframe > tick || tick - lastKeyframe >= keyframeInterval;
+
+        auto store = [&](const JPH::BodyID id) {
+            JPH::RVec3 position;
+            JPH::Quat rotation;
+            JPH::Vec3 linear, angular;
+            body_interface.GetPositionAndRotation(id, position, rotation);
+            body_interface.GetLinearAndAngularVelocity(id, linear, angular);
+
+            frame.bodies.emplace_back(id);
+            position.StoreFloat3(&frame.position.emplace_back());
+            rotation.GetXYZW().StoreFloat4(&frame.rotation.emplace_back());
+            linear.StoreFloat3(&frame.linearVelocity.emplace_back());
+            angular.StoreFloat3(&frame.angularVelocity.emplace_back());
+        };
+
+        for (const JPH::BodyID id : awake.bodies) store(id);
+        frame.awakeCount = static_cast<uint32_t>(frame.bodies.size());
+
+        if (frame.keyframe) {
+            system.GetBodies(scratchBodies);
+            for (const JPH::BodyID id : scratchBodies) {
+                if (!awake.contains(id) && body_interface.GetMotionType(id) != JPH::EMotionType::Static) store(id);
+            }
+            lastKeyframe = tick;
+        } else {
+            // Resting pose of the tick they fell asleep in, later frames don't have them anymore
+            for (const JPH::BodyID id : frozen) {
+                if (!awake.contains(id)) store(id);
+            }
+        }
+
+        latest = tick;
+
+        const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        stats.lastCaptureUs = us;
+        stats.peakCaptureUs = std::max(stats.peakCaptureUs, us);
+        stats.lastBytes = frame.bytes();
+        stats.peakBytes = std::max(stats.peakBytes, stats.lastBytes);
+    }
+
+    // Tick of the keyframe a restore of target starts from, INVALID_TICK when the ring doesn't reach back that far
+    [[nodiscard]] uint64_t restoreStart(const uint64_t target) const {
+        if (!enabled() || latest == INVALID_TICK || target > latest) return INVALID_TICK;
+
+        for (uint64_t tick = target; latest - tick < frames.size(); --tick) {
+            const Frame& candidate = frame(tick);
+            if (candidate.tick != tick) return INVALID_TICK;
+            if (candidate.keyframe) return tick;
+            if (tick == 0) break;
+        }
+
+        return INVALID_TICK;
+    }
+
+    // Writes the state of target back into the system, frozen is replaced by the bodies asleep at target so they get synced once
+    bool restore(const uint64_t target, JPH::PhysicsSystem& system, std::vector<JPH::BodyID>& frozen) {
+        const uint64_t start = restoreStart(target);
+        if (start == INVALID_TICK) return false;
+
+        // Whatever fell asleep before the rewind is either rewritten below or belongs to the discarded future
+        frozen.clear();
+
+        // Newest entry per body across the frames, so every body is written once
+        for (uint64_t tick = start; tick <= target; ++tick) {
+            const Frame& current = frame(tick);
+            for (uint32_t entry = 0; entry < current.bodies.size(); ++entry) {
+                const uint32_t index = current.bodies[entry].GetIndex();
+                if (index >= sources.size()) sources.resize(index + 1, Source{});
+                if (sources[index].tick == INVALID_TICK) touched.emplace_back(current.bodies[entry]);
+
+                sources[index] = {tick, entry};
+            }
+        }
+
+        JPH::BodyInterface &body_interface = system.GetBodyInterfaceNoLock();
+        const Frame& last = frame(target);
+
+        for (const JPH::BodyID id : touched) {
+            const auto [tick, entry] = sources[id.GetIndex()];
+            sources[id.GetIndex()] = Source{};
+
+            if (!body_interface.IsAdded(id)) continue;
+
+            const Frame& source = frame(tick);
+            const JPH::Float4& rotation = source.rotation[entry];
+
+            body_interface.SetPositionAndRotation(id, JPH::RVec3(JPH::Vec3(source.position[entry])), JPH::Quat(rotation.x, rotation.y, rotation.z, rotation.w), JPH::EActivation::DontActivate);
+            body_interface.SetLinearAndAngularVelocity(id, JPH::Vec3(source.linearVelocity[entry]), JPH::Vec3(source.angularVelocity[entry]));
+
+            if (tick == target && entry < last.awakeCount) {
+                body_interface.ActivateBody(id);
+            } else {
+                body_interface.DeactivateBody(id);
+                frozen.emplace_back(id);
+            }
+        }
+        touched.clear();
+
+        // Frames past target describe a future that is about to be resimulated
+        latest = target;
+        if (lastKeyframe > target) lastKeyframe = start;
+
+        return true;
+    }
+
+    [[nodiscard]] size_t memory() const {
+        size_t bytes = 0;
+        for (const Frame& current : frames) {
+            bytes += current.bodies.capacity() * BYTES_PER_BODY;
+        }
+        return bytes;
+    }
+
+private:
+    struct Source {
+        uint64_t tick = INVALID_TICK;
+        uint32_t entry = 0;
+    };
+
+    JPH::BodyIDVector scratchBodies{};
+    std::vector<Source> sources{};
+    std::vector<JPH::BodyID> touched{};
+};
+
+#endif //INC_2G43S_PHYSICSHISTORY_H
@@ -0,0 +1,155 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#include "PhysicsBus.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+#pragma region Main
+void PhysicsWorld::initialize(const PhysicsWorldSettings& worldSettings) {
+	settings = worldSettings;
+
+	temp_allocator = new JPH::TempAllocatorImpl(settings.allocatorSize);
+	physics_system = new JPH::PhysicsSystem();
+
+	// Physics parameters
+	constexpr uint cNumBodyMutexes = 0;
+
+	// Layer interfaces are referenced by the PhysicsSystem, custom ones come from the settings and are owned by the caller
+	if (!settings.bpInterface) settings.bpInterface = bp_interface = new BPLayerInterfaceImpl();
+	if (!settings.objBpFilter) settings.objBpFilter = obj_bp_filter = new ObjectVsBroadPhaseLayerFilterImpl();
+	if (!settings.objObjFilter) settings.objObjFilter = obj_obj_filter = new ObjectLayerPairFilterImpl();
+
+	physics_system->Init(settings.maxBodies, cNumBodyMutexes, settings.maxBodyPairs, settings.maxContactConstraints, *settings.bpInterface, *settings.objBpFilter, *settings.objObjFilter);
+
+	// Both listeners are called from jobs, so whatever they do needs to be thread safe
+	body_activation_listener = new MyBodyActivationListener();
+	physics_system->SetBodyActivationListener(body_activation_listener);
+
+	contact_queue = new ContactQueue(settings.contactQueueSize, settings.contactOverflowPolicy);
+	contact_listener = new MyContactListener(contact_queue);
+	physics_system->SetContactListener(contact_listener);
+
+	physics_system->SetGravity(JPH::Vec3(settings.gravity.x, settings.gravity.y, settings.gravity.z));
+
+	history.initialize(settings.historyTicks, settings.historyKeyframeInterval);
+}
+
+void PhysicsWorld::update(const float deltaTime, const PhysicsStepper& stepper, JPH::JobSystem* job_system) {
+	physics_system->Update(deltaTime, chooseCollisionSteps(deltaTime, stepper), temp_allocator, job_system);
+
+	updateAwakeSet();
+
+	// Feed the next step count decision
+	const JPH::BodyInterface &body_interface = physics_system->GetBodyInterfaceNoLock();
+
+	float maxSpeed2 = 0;
+	for (const JPH::BodyID id : awakeBodies.bodies) {
+		maxSpeed2 = std::max(maxSpeed2, body_interface.GetLinearVelocity(id).LengthSq());
+	}
+
+	maxSpeed = std::sqrt(maxSpeed2);
+	maxPenetration = contact_listener->takeMaxPenetration();
+}
+
+int PhysicsWorld::chooseCollisionSteps(const float deltaTime, const PhysicsStepper& stepper) {
+	int steps = static_cast<int>(std::ceil(maxSpeed * deltaTime / stepper.maxTravelPerStep));
+	if (maxPenetration > stepper.penetrationSlop) steps++;
+
+	collisionSteps = std::clamp(steps, stepper.minCollisionSteps, stepper.maxCollisionSteps);
+	return collisionSteps;
+}
+
+void PhysicsWorld::updateAwakeSet() {
+	body_activation_listener->drain(activationEvents);
+
+	for (const auto& [id, awake] : activationEvents) {
+		if (awake) {
+			awakeBodies.insert(id);
+		} else if (awakeBodies.erase(id)) {
+			frozenBodies.emplace_back(id);
+		}
+	}
+}
+
+void PhysicsWorld::updateLod(const PhysicsLod& lod) {
+	JPH::BodyInterface &body_interface = physics_system->GetBodyInterface();
+
+	const float reduced2 = lod.reducedRadius * lod.reducedRadius;
+	const float sleep2 = lod.sleepRadius * lod.sleepRadius;
+	const float wake = std::max(0.0f, lod.sleepRadius - lod.wakeMargin);
+
+	auto distance2 = [&](const JPH::BodyID id) {
+		const JPH::RVec3 pos = body_interface.GetCenterOfMassPosition(id);
+		const glm::vec3 delta = glm::vec3(pos.GetX(), pos.GetY(), pos.GetZ()) - lod.focus;
+		return glm::dot(delta, delta);
+	};
+
+	// Wake forced sleepers that are close again, natural sleepers will just fall asleep again next tick
+	std::erase_if(lodSleeping, [&](const JPH::BodyID id) {
+		if (!body_interface.IsAdded(id) || body_interface.IsActive(id)) return true;
+		if (distance2(id) > wake * wake) return false;
+
+		body_interface.ActivateBody(id);
+		return true;
+	});
+
+	// Deactivation goes through the listener, so awakeBodies stays untouched while iterating
+	for (const JPH::BodyID id : awakeBodies.bodies) {
+		const float d2 = distance2(id);
+
+		if (d2 > sleep2) {
+			body_interface.DeactivateBody(id);
+			lodSleeping.emplace_back(id);
+			continue;
+		}
+
+		const uint32_t index = id.GetIndex();
+		if (index >= reducedBand.size()) reducedBand.resize(index + 1, 0);
+
+		if (const uint8_t band = d2 > reduced2; reducedBand[index] != band) {
+			reducedBand[index] = band;
+			body_interface.SetMotionQuality(id, band ? JPH::EMotionQuality::Discrete : JPH::EMotionQuality::LinearCast);
+		}
+	}
+}
+
+bool PhysicsWorld::inReducedBand(const JPH::BodyID id) const {
+	const uint32_t index = id.GetIndex();
+	return index < reducedBand.size() && reducedBand[index];
+}
+
+bool PhysicsWorld::contains(const glm::vec3& pos) const {
+	return glm::all(glm::greaterThanEqual(pos, settings.boundsMin)) && glm::all(glm::lessThan(pos, settings.boundsMax));
+}
+
+void PhysicsWorld::shutdown() {
+	JPH::BodyInterface &body_interface = physics_system->GetBodyInterface();
+
+	JPH::BodyIDVector bodies;
+	physics_system->GetBodies(bodies);
+
+	for (JPH::BodyID id : bodies) {
+		body_interface.RemoveBody(id);
+		body_interface.DestroyBody(id);
+	}
+
+	delete physics_system;
+	delete bp_interface;
+	delete obj_bp_filter;
+	delete obj_obj_filter;
+	delete temp_allocator;
+	delete body_activation_listener;
+	delete contact_listener;
+	delete contact_queue;
+
+	awakeBodies.clear();
+	frozenBodies.clear();
+	reducedBand.clear();
+	lodSleeping.clear();
+	history.initialize(0, settings.historyKeyframeInterval);
+}
+#pragma endregion
@@ -0,0 +1,93 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_SCENEQUERY_H
+#define INC_2G43S_SCENEQUERY_H
+
+#include <cstdint>
+#include <vector>
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/BodyID.h>
+#include <glm/glm.hpp>
+
+struct RayQuery {
+    glm::vec3 origin{};
+    glm::vec3 direction{}; // Length of the ray is the length of direction
+};
+
+struct SphereCastQuery {
+    glm::vec3 origin{};
+    float radius = 0.5f;
+    glm::vec3 direction{};
+};
+
+struct OverlapQuery {
+    glm::vec3 center{};
+    float radius = 1.0f;
+};
+
+struct SceneQueryBatch {
+    std::vector<RayQuery> rays{};
+    std::vector<SphereCastQuery> sphereCasts{};
+    std::vector<OverlapQuery> overlaps{};
+
+    uint32_t maxOverlapHits = 16; // Bodies reported per overlap, rest are ignored
+
+    [[nodiscard]] size_t size() const {
+        return rays.size() + sphereCasts.size() + overlaps.size();
+    }
+
+    void clear() {
+        rays.clear();
+        sphereCasts.clear();
+        overlaps.clear();
+    }
+};
+
+// Flat SoA hit buffer, queries are numbered rays first, then sphere casts, then overlaps.
+// Rays and casts own one hit slot (closest hit), overlaps own maxOverlapHits slots
+struct SceneQueryResults {
+    // Per query
+    std::vector<uint32_t> firstHit{};
+    std::vector<uint32_t> hitCount{};
+
+    // Per hit slot
+    std::vector<JPH::BodyID> body{};
+    std::vector<float> fraction{}; // Fraction of direction for rays and casts, penetration depth for overlaps
+    std::vector<glm::vec3> point{};
+    std::vector<glm::vec3> normal{};
+
+    size_t sphereCastOffset = 0;
+    size_t overlapOffset = 0;
+
+    void prepare(const SceneQueryBatch& batch) {
+        sphereCastOffset = batch.rays.size();
+        overlapOffset = sphereCastOffset + batch.sphereCasts.size();
+
+        const size_t queries = batch.size();
+        const size_t slots = overlapOffset + batch.overlaps.size() * batch.maxOverlapHits;
+
+        firstHit.resize(queries);
+        hitCount.assign(queries, 0);
+
+        for (size_t i = 0; i < overlapOffset; ++i) {
+            firstHit[i] = static_cast<uint32_t>(i);
+        }
+        for (size_t i = 0; i < batch.overlaps.size(); ++i) {
+            firstHit[overlapOffset + i] = static_cast<uint32_t>(overlapOffset + i * batch.maxOverlapHits);
+        }
+
+        body.resize(slots);
+        fraction.resize(slots);
+        point.resize(slots);
+        normal.resize(slots);
+    }
+
+    [[nodiscard]] bool hit(const size_t query) const {
+        return hitCount[query] > 0;
+    }
+};
+
+#endif //INC_2G43S_SCENEQUERY_H
@@ -5,13 +5,19 @@
 
 #include "BufferManager.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
 #include <cstring>
 
 
 #include "Camera.hpp"
 #include "DeltaManager.hpp"
+#include "FrustumCuller.hpp"
 #include "ModelEntityManager.hpp"
+#include "Barrier.h"
 #include "glmMath.h"
+#include "Logger.hpp"
 #include "SwapchainManager.hpp"
 
 #pragma region Update
@@ -74,51 +80,132 @@ void BufferManager::updateCullingUniformBuffer(uint32_t currentFrame) {
     uniformCullingBufferObject.planes[2] = extractPlane(viewProjection, 1, +1); // top
     uniformCullingBufferObject.planes[3] = extractPlane(viewProjection, 1, -1); // bottom
     uniformCullingBufferObject.planes[4] = extractPlane(viewProjection, 2, +1); // far
-    uniformCullingBufferObject.planes[5] = extractPlane(viewProjection, 2, -1); // near
+
+    // Depth is 0..1, so near is z >= 0 alone, not z >= -w
+    glm::vec4 nearPlane(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+    normalizePlane(nearPlane);
+    uniformCullingBufferObject.planes[5] = nearPlane;
+
+    uniformCullingBufferObject.viewProjection = viewProjection;
+    uniformCullingBufferObject.pixelScale = std::abs(proj[1][1]) * 0.5f * static_cast<float>(swapchainManager->swapchainExtent.height);
+    uniformCullingBufferObject.minPixelRadius = minPixelRadius;
+    uniformCullingBufferObject.impostorDistance = impostorDistance;
+    uniformCullingBufferObject.impostorRows = impostorAtlas.baked ? impostorAtlas.rows : 0;
+    uniformCullingBufferObject.pyramidLevelCount = depthPyramid.levelCount;
+    uniformCullingBufferObject.depthWidth = depthPyramid.extent.width;
+    uniformCullingBufferObject.depthHeight = depthPyramid.extent.height;
+    for (uint32_t i = 0; i < depthPyramid.levelCount; ++i) {
+        const auto& level = depthPyramid.levels[i];
+        uniformCullingBufferObject.pyramidLevels[i] = glm::uvec4(level.offset, level.width, level.height, 0);
+    }
 
     memcpy(uniformCullingBuffersMapped[currentFrame], &uniformCullingBufferObject, sizeof(uniformCullingBufferObject));
 }
 
 
 // Matrices
-void BufferManager::updateModelDataBuffer(uint32_t currentFrame) {
-    static size_t frame = 0;
-
-    if (modelEntityManager->dirty[0]) {
-        auto* dst = static_cast<glm::vec4*>(modelDataBuffersMapped[currentFrame]);
-        size_t i = 0;
-        for (const auto& group : std::views::transform(modelEntityManager->groups, &ModelGroup::instances)) {
-            for (const auto& model_instance : group) {
-                dst[i * 3 + 0] = model_instance.pos;
-                dst[i * 3 + 1] = model_instance.rot;
-                dst[i * 3 + 2] = model_instance.scl;
-                i++;
+void BufferManager::updateDirtyRanges() {
+    const size_t total = modelEntityManager->getTotalInstanceCount();
+    DirtyRanges& changed = modelEntityManager->changedInstances;
+
+    if (modelEntityManager->dirty[0] || modelEntityManager->dirty[2]) {
+        changed.clear();
+        changed.add(0, total);
+        modelEntityManager->dirty[0] = false;
+        modelEntityManager->dirty[2] = false;
+    }
+
+    if (changed.empty()) return;
+
+    std::lock_guard lock(uploadMutex);
+    changed.clamp(total);
+    changed.coalesce(0, SIZE_MAX);
+
+    // Refresh the host copies of the changed instances, streamed matrices and spheres are already in place
+    matDataBufferObject.packed.resize(total * 3);
+    matCullingBufferObject.cullingDatas.resize(total, CullingData(glm::vec4(0), 0));
+
+    size_t base = 0;
+    uint16_t index = 0;
+    for (const auto& group : std::views::transform(modelEntityManager->groups, &ModelGroup::instances)) {
+        for (const auto& range : changed.ranges) {
+            const size_t begin = std::max(range.begin, base);
+            const size_t end = std::min(range.end, base + group.size());
+
+            for (size_t i = begin; i < end; ++i) {
+                const auto& model_instance = group[i - base];
+
+                matDataBufferObject.packed[i * 3 + 0] = model_instance.pos;
+                matDataBufferObject.packed[i * 3 + 1] = model_instance.rot;
+                matDataBufferObject.packed[i * 3 + 2] = model_instance.scl;
+
+                const glm::mat4 model = FrustumCuller::instanceMatrix(model_instance.pos, model_instance.rot, model_instance.scl);
+                matCullingBufferObject.cullingDatas[i] = CullingData(FrustumCuller::worldSphere(model_instance.mdl.lock()->sphere, model), index);
             }
         }
 
-        frame++;
-        if (frame == MAX_FRAMES_IN_FLIGHT) modelEntityManager->dirty[0] = false;
+        base += group.size();
+        index++;
+    }
+
+    modelDataRanges.resize(MAX_FRAMES_IN_FLIGHT);
+    for (auto& ranges : modelDataRanges) {
+        ranges.add(changed);
+    }
+    cullingRanges.add(changed);
+
+    changed.clear();
+}
+
+// Matrices
+void BufferManager::updateModelDataBuffer(uint32_t currentFrame) {
+    std::lock_guard lock(uploadMutex);
+    if (currentFrame >= modelDataRanges.size() || modelDataRanges[currentFrame].empty()) return;
+
+    // Every frame has its own copy, each one catches up when its frame comes around
+    DirtyRanges& ranges = modelDataRanges[currentFrame];
+    ranges.clamp(std::min<size_t>(matDataBufferObject.packed.size() / 3, instanceCapacity));
+    ranges.coalesce(UPLOAD_GAP, MAX_UPLOAD_REGIONS);
+
+    for (const auto& [begin, end] : ranges.ranges) {
+        write(modelDataBuffers[currentFrame], modelDataBuffersMapped[currentFrame], begin * sizeof(glm::vec4) * 3, &matDataBufferObject.packed[begin * 3], (end - begin) * sizeof(glm::vec4) * 3);
     }
+
+    ranges.clear();
 }
 
 void BufferManager::initializeModelBuffer() {
     if (!modelBufferInitialized) {
         matBufferObject.models.clear();
         matBufferObject.models.resize(modelEntityManager->getTotalInstanceCount());
-        for (const auto& object : modelBuffersMapped) {
-            memcpy(object, matBufferObject.models.data(), sizeof(glm::mat4) * matBufferObject.models.size());
-        }
+
+        std::lock_guard lock(uploadMutex);
+        writeAll(modelBuffers, modelBuffersMapped, 0, matBufferObject.models.data(), sizeof(glm::mat4) * matBufferObject.models.size());
 
         modelBufferInitialized = true;
     }
 }
 
 void BufferManager::updateModelBuffer() {
+    std::lock_guard lock(uploadMutex);
+
     if (modelEntityManager->dirty[1]) {
         matBufferObject.models.resize(modelEntityManager->getTotalInstanceCount());
 
         modelEntityManager->dirty[1] = false;
     }
+
+    if (modelRanges.empty()) return;
+
+    // The host copy only holds streamed matrices, the rest come from the matrix shader, so gaps can't be merged
+    modelRanges.clamp(std::min<size_t>(matBufferObject.models.size(), instanceCapacity));
+    modelRanges.coalesce(0, MAX_UPLOAD_REGIONS);
+
+    for (const auto& [begin, end] : modelRanges.ranges) {
+        writeAll(modelBuffers, modelBuffersMapped, begin * sizeof(glm::mat4), &matBufferObject.models[begin], (end - begin) * sizeof(glm::mat4));
+    }
+
+    modelRanges.clear();
 }
 
 void BufferManager::updateSingleModel(const std::string &name, const uint32_t instanceIndex, glm::mat4 matrix) {
@@ -128,94 +215,90 @@ void BufferManager::updateSingleModel(const std::string &name, const uint32_t in
     matrix[0] = glm::normalize(matrix[0]) * scale.x;
     matrix[1] = glm::normalize(matrix[1]) * scale.y;
     matrix[2] = glm::normalize(matrix[2]) * scale.z;
-    matBufferObject.models[instanceIndex] = matrix;
-
-    size_t modelIndex = 0;
-    for (int i = 0; i < modelEntityManager->indexedFiles.size(); ++i) {
-        if (modelEntityManager->indexedFiles[i] == name) modelIndex = modelEntityManager->indexedFiles.size() - 1;
-    }
 
-    const size_t globalInstanceIdx = modelIndex + instanceIndex;
-    const size_t matOffset = globalInstanceIdx * sizeof(glm::mat4);
-    const size_t sphereOffset = globalInstanceIdx * sizeof(CullingData);
+    const size_t globalInstanceIdx = modelEntityManager->getGlobalIndex(name, instanceIndex);
 
-    for (void* mappedPtr : modelBuffersMapped) {
-        void* targetAddress = static_cast<char*>(mappedPtr) + matOffset;
+    // Uploaded once per frame, however many ticks touched it
+    std::lock_guard lock(uploadMutex);
+    if (globalInstanceIdx >= matBufferObject.models.size() || globalInstanceIdx >= matCullingBufferObject.cullingDatas.size()) return;
 
-        memcpy(targetAddress, &matrix, sizeof(glm::mat4));
-    }
+    matBufferObject.models[globalInstanceIdx] = matrix;
+    modelRanges.add(globalInstanceIdx);
 
-    matCullingBufferObject.cullingDatas[globalInstanceIdx].sphere = modelEntityManager->groups[modelEntityManager->indices[name]].model->sphere + glm::vec4(matrix[3]);
-    void* targetAddress = static_cast<char*>(modelCullingBufferMapped) + sphereOffset;
-    memcpy(targetAddress, &matCullingBufferObject.cullingDatas[globalInstanceIdx], sizeof(CullingData));
+    matCullingBufferObject.cullingDatas[globalInstanceIdx].sphere = FrustumCuller::worldSphere(modelEntityManager->groups[modelEntityManager->indices[name]].model->sphere, matrix);
+    cullingRanges.add(globalInstanceIdx);
 }
 
 void BufferManager::addModel(const std::string &name, glm::vec4 pos) {
     if (!modelBufferInitialized) return;
 
     modelEntityManager->staticInstance(name, pos);
+    reserve(modelEntityManager->getTotalInstanceCount(), modelEntityManager->regions.size());
 
     glm::mat4 identityMatrix = glm::mat4(1.0f);
     glm::mat4 matrix = glm::translate(identityMatrix, glm::vec3(pos.x, pos.y, pos.z));
 
-    matBufferObject.models.emplace_back(matrix);
-
-
     const size_t totalModels = modelEntityManager->getTotalInstanceCount();
-    const size_t matOffset = (totalModels - 1) * sizeof(glm::mat4);
-    const size_t sphereOffset = (totalModels - 1) * sizeof(CullingData);
 
     // Model buffer
-    for (void* mappedPtr : modelBuffersMapped) {
-        void* targetAddress = static_cast<char*>(mappedPtr) + matOffset;
-
-        memcpy(targetAddress, &matrix, sizeof(glm::mat4));
+    {
+        std::lock_guard lock(uploadMutex);
+        matBufferObject.models.emplace_back(matrix);
+        modelRanges.add(totalModels - 1);
     }
+}
 
-    // Culling buffer
-    /*
-    size_t modelIndex = 0;
-    for (int i = 0; i < modelEntityManager->indexedFiles.size(); ++i) {
-        if (modelEntityManager->indexedFiles[i] == name) modelIndex = modelEntityManager->indexedFiles.size() - 1;
-    }
-    matCullingBufferObject.cullingDatas.emplace_back(
-        modelEntityManager->groups[modelEntityManager->indices[name]].model->sphere + glm::vec4(matrix[3]),
-        modelIndex
-        );
-    void* targetAddress = static_cast<char*>(modelCullingBufferMapped) + sphereOffset;
-    memcpy(targetAddress, &matCullingBufferObject.cullingDatas.back(), sizeof(CullingData));
-    */
 
-    auto* commands = static_cast<VkDrawIndexedIndirectCommand*>(drawCommandsSourceBuffersMapped[0]);
+// Culling
+void BufferManager::updateModelCullingBuffer() {
+    std::lock_guard lock(uploadMutex);
+    if (cullingRanges.empty()) return;
 
-    uint32_t modelIdx = 1;
-    uint32_t gpuSideInstanceCount = commands[modelIdx].instanceCount;
+    cullingRanges.clamp(std::min<size_t>(matCullingBufferObject.cullingDatas.size(), instanceCapacity));
+    cullingRanges.coalesce(UPLOAD_GAP, MAX_UPLOAD_REGIONS);
 
-    std::cout << "GPU updated instance count: " << gpuSideInstanceCount << std::endl;
+    for (const auto& [begin, end] : cullingRanges.ranges) {
+        write(modelCullingBuffer, modelCullingBufferMapped, begin * sizeof(CullingData), &matCullingBufferObject.cullingDatas[begin], (end - begin) * sizeof(CullingData));
+    }
+
+    cullingRanges.clear();
 }
 
+void BufferManager::cullOnCpu(const uint32_t currentFrame, const ShaderSpecialization& specialization) {
+    std::lock_guard lock(uploadMutex);
 
-// Culling
-void BufferManager::updateModelCullingBuffer() {
-    if (modelEntityManager->dirty[2]) {
-        matCullingBufferObject.cullingDatas.clear();
-        matCullingBufferObject.cullingDatas.reserve(modelEntityManager->getTotalInstanceCount());
-
-        uint16_t index = 0;
-        for (const auto& group : std::views::transform(modelEntityManager->groups, &ModelGroup::instances)) {
-            for (const auto& model_instance : group) {
-                glm::vec4 sphere = model_instance.mdl.lock()->sphere + model_instance.pos;
-                sphere.w *= glm::compMax(model_instance.scl);
-                matCullingBufferObject.cullingDatas.emplace_back(sphere, index);
-            }
+    drawCommandsObject.commands = drawCommandsSourceObject.commands;
+    const size_t count = std::min<size_t>(matCullingBufferObject.cullingDatas.size(), instanceCapacity);
+    std::vector<uint32_t> impostors{};
+    FrustumCuller::cull(matCullingBufferObject.cullingDatas, count, uniformCullingBufferObject, specialization, drawCommandsObject.commands, visibleIndicesObject.vi, impostors);
 
-            index++;
-        }
+    // Same compacted early list the gpu path draws
+    std::vector<CompactedDrawCommand> compacted{};
+    for (uint32_t i = 0; i < drawCommandsObject.commands.size(); ++i) {
+        if (drawCommandsObject.commands[i].instanceCount > 0) compacted.emplace_back(drawCommandsObject.commands[i]);
+    }
 
-        memcpy(modelCullingBufferMapped, matCullingBufferObject.cullingDatas.data(), matCullingBufferObject.cullingDatas.size() * sizeof(CullingData));
+    AtomicCounterBuffer counts{};
+    counts.counters[0] = static_cast<uint32_t>(compacted.size());
 
-        modelEntityManager->dirty[2] = false;
-    }
+    write(visibleIndicesBuffers[currentFrame], visibleIndicesBuffersMapped[currentFrame], 0, visibleIndicesObject.vi.data(), sizeof(uint32_t) * visibleIndicesObject.vi.size());
+    write(compactedDrawCommandsBuffers[currentFrame], compactedDrawCommandsBuffersMapped[currentFrame], 0, compacted.data(), sizeof(CompactedDrawCommand) * compacted.size());
+    write(atomicCounterBuffers[currentFrame], atomicCounterBuffersMapped[currentFrame], 0, &counts, sizeof(counts));
+
+    const ImpostorList list{{6, static_cast<uint32_t>(impostors.size()), 0, 0}};
+    write(impostorBuffers[currentFrame], impostorBuffersMapped[currentFrame], 0, &list, sizeof(list));
+    write(impostorBuffers[currentFrame], impostorBuffersMapped[currentFrame], sizeof(list), impostors.data(), sizeof(uint32_t) * impostors.size());
+}
+
+void BufferManager::validateCulling(const uint32_t currentFrame, const ShaderSpecialization& specialization) {
+    std::lock_guard lock(uploadMutex);
+
+    cullingValidation.check(currentFrame);
+    cullingValidation.begin(
+        device, physicalDevice, currentFrame, sizeof(CompactedDrawCommand) * 2 * modelCapacity,
+        matCullingBufferObject.cullingDatas, std::min<size_t>(matCullingBufferObject.cullingDatas.size(), instanceCapacity),
+        uniformCullingBufferObject, specialization, drawCommandsSourceObject.commands
+        );
 }
 
 void BufferManager::updateVisibleIndicesBuffer() {
@@ -274,137 +357,310 @@ void BufferManager::updateDrawCommands() {
         std::cout << "vertexOffset: " << command.vertexOffset << std::endl;
     }
 }
+#pragma endregion
 
-void BufferManager::updateTextureIndexBuffer() {
-    static bool initialized = false;
+#pragma region Growth
+bool BufferManager::reserve(const size_t instances, const size_t models) {
+    if (instances <= instanceCapacity && models <= modelCapacity) return false;
 
-    if (!initialized) {
-        size_t i = 0;
-        const size_t count = modelEntityManager->getTotalModelCount();
-        uint32_t currentGlobalVertexOffset = 0;
-
-        textureIndexBufferObject.indices.resize(count);
-
-        for (const auto& model : modelEntityManager->groups | std::views::transform(&ModelGroup::model)) {
-            auto& textures = model->textures;
-
-            if (textures.empty()) {
-                textureIndexBufferObject.indices[i].firstIndex = 0;
-                textureIndexBufferObject.indices[i].indexCount = 0;
-            } else {
-                textureIndexBufferObject.indices[i].firstIndex = textures[0].index;
-                textureIndexBufferObject.indices[i].indexCount = textures.size();
-                textureIndexBufferObject.indices[i].globalVertexOffset = currentGlobalVertexOffset;
-
-                //std::cout << "==================" << std::endl;
-                //std::cout << "First index: " << textures[0].index << std::endl;
-                //std::cout << "Tex count: " << textureIndexBuffer.indices[i].indexCount << std::endl;
-                //std::cout << "Padding index: " << textureIndexBuffer.indices[i].globalVertexOffset << std::endl;
-                //std::cout << "==================" << std::endl;
-                for (const auto & texture : textures) {
-                    const uint32_t offset = texture.indexOffset;
-                    TextureIndexOffsetBufferObject.indexOffsets.emplace_back(offset);
-                    //std::cout << "Tex offset: " << offset << std::endl;
-                }
-            }
+    std::lock_guard lock(uploadMutex);
+    Logger LOGGER{"BufferManager"};
 
-            uint32_t modelTotalVertices = 0;
-            for (const auto& mesh : model->meshes) {
-                modelTotalVertices += static_cast<uint32_t>(mesh.size());
-            }
-            currentGlobalVertexOffset += modelTotalVertices;
+    if (instances > instanceCapacity) {
+        const auto capacity = static_cast<uint32_t>(std::max<size_t>(instanceCapacity * 2ull, std::bit_ceil(instances)));
+
+        growBuffers(modelConstants, modelBuffers, modelBuffersMemory, modelBuffersMapped, sizeof(glm::mat4) * instanceCapacity, sizeof(glm::mat4) * capacity, GROWABLE_USAGE, hostWrittenMemory, true);
+        growBuffer(modelCullingConstant, modelCullingBuffer, modelCullingBufferMemory, modelCullingBufferMapped, sizeof(CullingData) * instanceCapacity, sizeof(CullingData) * capacity, GROWABLE_USAGE, hostWrittenMemory, true);
+
+        // Model data is uploaded again from the host copy, visible indices are rewritten by culling
+        growBuffers(modelDataConstants, modelDataBuffers, modelDataBuffersMemory, modelDataBuffersMapped, sizeof(glm::vec4) * 3 * instanceCapacity, sizeof(glm::vec4) * 3 * capacity, GROWABLE_USAGE, hostWrittenMemory, false);
+        growBuffers(visibleIndicesConstants, visibleIndicesBuffers, visibleIndicesBuffersMemory, visibleIndicesBuffersMapped, sizeof(uint32_t) * instanceCapacity, sizeof(uint32_t) * capacity, GROWABLE_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+        growBuffers(lateVisibleIndicesConstants, lateVisibleIndicesBuffers, lateVisibleIndicesBuffersMemory, lateVisibleIndicesBuffersMapped, sizeof(uint32_t) * instanceCapacity, sizeof(uint32_t) * capacity, GROWABLE_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
 
-            i++;
+        // Stale visibility only moves an instance between the two phases for one frame
+        growBuffer(visibilityConstant, visibilityBuffer, visibilityBufferMemory, visibilityBufferMapped, sizeof(uint32_t) * instanceCapacity, sizeof(uint32_t) * capacity, GROWABLE_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+        growBuffers(impostorConstants, impostorBuffers, impostorBuffersMemory, impostorBuffersMapped, sizeof(ImpostorList) + sizeof(uint32_t) * instanceCapacity, sizeof(ImpostorList) + sizeof(uint32_t) * capacity, DRAW_COMMANDS_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+        modelDataRanges.resize(MAX_FRAMES_IN_FLIGHT);
+        for (auto& ranges : modelDataRanges) {
+            ranges.add(0, matDataBufferObject.packed.size() / 3);
         }
 
-        //std::cout << "Index offsets count: " << TextureIndexOffsetBuffer.indexOffsets.size() << std::endl;
-        //std::cout << "Index offsets2 count: " << textureIndexBuffer.indices.size() << std::endl;
+        LOGGER.info("Instance capacity ${} -> ${}", instanceCapacity, capacity);
+        instanceCapacity = capacity;
+    }
+
+    if (models > modelCapacity) {
+        const auto capacity = static_cast<uint32_t>(std::max<size_t>(modelCapacity * 2ull, std::bit_ceil(models)));
 
-        memcpy(textureIndexBufferMapped, textureIndexBufferObject.indices.data(), sizeof(Index) * textureIndexBufferObject.indices.size());
-        memcpy(textureIndexOffsetBufferMapped, TextureIndexOffsetBufferObject.indexOffsets.data(), TextureIndexOffsetBufferObject.indexOffsets.size() * sizeof(uint32_t));
+        // Culling only rewrites the instance counts of both command lists, the rest has to survive
+        growBuffers(drawCommandsSourceConstants, drawCommandsSourceBuffers, drawCommandsSourceBuffersMemory, drawCommandsSourceBuffersMapped, sizeof(VkDrawIndexedIndirectCommand) * modelCapacity, sizeof(VkDrawIndexedIndirectCommand) * capacity, DRAW_COMMANDS_USAGE, hostWrittenMemory, true);
+        growBuffers(drawCommandsConstants, drawCommandsBuffers, drawCommandsBuffersMemory, drawCommandsBuffersMapped, sizeof(VkDrawIndexedIndirectCommand) * modelCapacity, sizeof(VkDrawIndexedIndirectCommand) * capacity, DRAW_COMMANDS_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+        growBuffers(compactedDrawCommandsConstants, compactedDrawCommandsBuffers, compactedDrawCommandsBuffersMemory, compactedDrawCommandsBuffersMapped, sizeof(CompactedDrawCommand) * 2 * modelCapacity, sizeof(CompactedDrawCommand) * 2 * capacity, DRAW_COMMANDS_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
 
-        initialized = true;
+        LOGGER.info("Model capacity ${} -> ${}", modelCapacity, capacity);
+        modelCapacity = capacity;
     }
+
+    return true;
 }
-#pragma endregion
 
-void BufferManager::createBuffers(VkQueue graphicsQueue, VkCommandPool graphicsCommandPool) {
-    BuffersRegistry::createVertexBuffer(device, physicalDevice, graphicsCommandPool, graphicsQueue, vertexBuffer, vertexBufferMemory, *modelEntityManager);
-    BuffersRegistry::createIndexBuffer(device, physicalDevice, graphicsCommandPool, graphicsQueue, indexBuffer, indexBufferMemory, *modelEntityManager);
+void BufferManager::beginFrame(const uint64_t completedValue) {
+    std::lock_guard lock(uploadMutex);
 
+    // Reaching a value means every earlier submit to the graphics queue finished as well
+    std::erase_if(retiredBuffers, [&](const RetiredBuffer& retired) {
+        if (retired.lastUse == RetiredBuffer::PENDING || retired.lastUse > completedValue) return false;
 
-    // Generic
-    BuffersRegistry::createGenericBuffers(device, physicalDevice, uniformConstants, uniformBuffers, uniformBuffersMemory, uniformBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(UniformBuffer), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    BuffersRegistry::createGenericBuffers(device, physicalDevice, uniformMatrixConstants, uniformMatrixBuffers, uniformMatrixBuffersMemory, uniformMatrixBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(UniformBuffer), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    BuffersRegistry::createGenericBuffers(device, physicalDevice, uniformPostprocessingConstants, uniformPostprocessingBuffers, uniformPostprocessingBuffersMemory, uniformPostprocessingBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(uniformPostprocessingBufferObject), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    BuffersRegistry::createGenericBuffers(device, physicalDevice, atomicCounterConstants, atomicCounterBuffers, atomicCounterBuffersMemory, atomicCounterBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        BuffersRegistry::destroyBuffer(device, retired.buffer, retired.memory);
+        return true;
+    });
+}
 
+void BufferManager::recordUploads(VkCommandBuffer commandBuffer, const uint64_t submitValue) {
+    std::lock_guard lock(uploadMutex);
 
-    // Matrices
-    BuffersRegistry::createGenericBuffers(device, physicalDevice, modelConstants, modelBuffers, modelBuffersMemory, modelBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(glm::mat4) * 2048, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    BuffersRegistry::createGenericBuffers(device, physicalDevice, modelDataConstants, modelDataBuffers, modelDataBuffersMemory, modelDataBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(glm::vec4) * 2048, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    // Everything written below, earlier frames may still be reading or writing it.
+    // Barriers order against everything submitted before, not just this command buffer
+    std::vector<VkBuffer> targets{};
+    for (const auto& upload : stagingRing.uploads) {
+        if (std::ranges::find(targets, upload.dst) == targets.end()) targets.emplace_back(upload.dst);
+    }
 
-    // Culling
-    BuffersRegistry::createGenericBuffers(device, physicalDevice, uniformCullingConstants, uniformCullingBuffers, uniformCullingBuffersMemory, uniformCullingBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(UniformCullingBuffer), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    BuffersRegistry::createGenericBuffers(device, physicalDevice, visibleIndicesConstants, visibleIndicesBuffers, visibleIndicesBuffersMemory, visibleIndicesBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(uint32_t) * 2048, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    BuffersRegistry::createGenericBuffer(device, physicalDevice, modelCullingConstant, modelCullingBuffer, modelCullingBufferMemory, modelCullingBufferMapped, sizeof(CullingData) * 2048, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (!pendingCopies.empty() || !targets.empty()) {
+        Barrier before(commandBuffer);
+        for (const auto& copy : pendingCopies) {
+            before.buffer(
+                copy.src,
+                VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                VK_ACCESS_2_MEMORY_WRITE_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+                VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                0, copy.size
+            );
+        }
+        for (const VkBuffer target : targets) {
+            before.buffer(
+                target,
+                VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                0, VK_WHOLE_SIZE
+            );
+        }
+        before.apply();
+    }
 
+    // Growth first, staged writes target the grown buffers and have to land on top of the old contents
+    if (!pendingCopies.empty()) {
+        for (const auto& copy : pendingCopies) {
+            VkBufferCopy copyRegion{};
+            copyRegion.size = copy.size;
+            vkCmdCopyBuffer(commandBuffer, copy.src, copy.dst, 1, &copyRegion);
+        }
 
-    BuffersRegistry::createGenericBuffer(device, physicalDevice, textureIndexConstant, textureIndexBuffer, textureIndexBufferMemory, textureIndexBufferMapped, sizeof(uint32_t) * 4 * 128, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-    BuffersRegistry::createGenericBuffer(device, physicalDevice, textureIndexOffsetConstant, textureIndexOffsetBuffer, textureIndexOffsetBufferMemory, textureIndexOffsetBufferMapped, sizeof(uint32_t) * 128, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        Barrier grown(commandBuffer);
+        for (const auto& copy : pendingCopies) {
+            grown.buffer(
+                copy.dst,
+                VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                0, copy.size
+            );
+        }
+        grown.apply();
 
-    // Draw commands shenanigans
-    updateDrawCommands();
-    BuffersRegistry::createGenericBuffers(device, physicalDevice, drawCommandsSourceConstants, drawCommandsSourceBuffers, drawCommandsSourceBuffersMemory, drawCommandsSourceBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(VkDrawIndexedIndirectCommand) * 1024, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    BuffersRegistry::createGenericBuffers(device, physicalDevice, drawCommandsConstants, drawCommandsBuffers, drawCommandsBuffersMemory, drawCommandsBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(VkDrawIndexedIndirectCommand) * 1024, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        pendingCopies.clear();
+    }
 
-    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-        memcpy(drawCommandsSourceBuffersMapped[i], drawCommandsSourceObject.commands.data(), sizeof(VkDrawIndexedIndirectCommand) * drawCommandsSourceObject.commands.size());
-        //memcpy(drawCommandsBuffersMapped[i], drawCommandsObj.commands.data(), sizeof(VkDrawIndexedIndirectCommand) * drawCommandsObj.commands.size());
+    stagingRing.record(commandBuffer);
+
+    if (!targets.empty()) {
+        Barrier after(commandBuffer);
+        for (const VkBuffer target : targets) {
+            after.buffer(
+                target,
+                VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                0, VK_WHOLE_SIZE
+            );
+        }
+        after.apply();
     }
 
-    initializeModelBuffer();
+    // Buffers retired before this frame may be referenced by it, at least through the copy
+    for (auto& retired : retiredBuffers) {
+        if (retired.lastUse == RetiredBuffer::PENDING) retired.lastUse = submitValue;
+    }
 }
 
-void BufferManager::cleanup() const {
+void BufferManager::growBuffer(
+    uint64_t& constant, VkBuffer& buffer, GpuAllocation& bufferMemory, void*& bufferMapped,
+    const VkDeviceSize oldSize, const VkDeviceSize newSize, const int usageFlags, const int memoryFlags, const bool preserve
+    ) {
+
+    uint64_t grownConstant{};
+    VkBuffer grown{};
+    GpuAllocation grownMemory{};
+    void* grownMapped{};
+    BuffersRegistry::createGenericBuffer(device, physicalDevice, grownConstant, grown, grownMemory, grownMapped, newSize, usageFlags, memoryFlags);
+
+    // Staged writes queued for the old buffer go to the new one, after the growth copy
+    stagingRing.retarget(buffer, grown);
+
+    if (preserve) {
+        // Grown twice before a frame was recorded, copy straight from the oldest buffer
+        if (const auto chained = std::ranges::find(pendingCopies, buffer, &BufferCopy::dst); chained != pendingCopies.end()) {
+            chained->dst = grown;
+        } else {
+            pendingCopies.emplace_back(buffer, grown, oldSize);
+        }
+
+        if (grownMapped) {
+            for (auto& retired : retiredBuffers) {
+                if (retired.successor == bufferMapped) retired.successor = grownMapped;
+            }
+        }
+    }
+
+    retiredBuffers.emplace_back(buffer, bufferMemory, oldSize, preserve ? grownMapped : nullptr);
+
+    constant = grownConstant;
+    buffer = grown;
+    bufferMemory = grownMemory;
+    bufferMapped = grownMapped;
+}
+
+void BufferManager::growBuffers(
+    std::vector<uint64_t>& constants, std::vector<VkBuffer>& buffers, std::vector<GpuAllocation>& buffersMemory, std::vector<void*>& buffersMapped,
+    const VkDeviceSize oldSize, const VkDeviceSize newSize, const int usageFlags, const int memoryFlags, const bool preserve
+    ) {
+
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vkDestroyBuffer(device, uniformBuffers[i], nullptr);
-        vkFreeMemory(device, uniformBuffersMemory[i], nullptr);
+        growBuffer(constants[i], buffers[i], buffersMemory[i], buffersMapped[i], oldSize, newSize, usageFlags, memoryFlags, preserve);
+    }
+}
 
-        vkDestroyBuffer(device, uniformMatrixBuffers[i], nullptr);
-        vkFreeMemory(device, uniformMatrixBuffersMemory[i], nullptr);
+void BufferManager::write(VkBuffer buffer, void* mapped, const size_t offset, const void* data, const size_t size) {
+    if (size == 0) return;
 
-        vkDestroyBuffer(device, modelBuffers[i], nullptr);
-        vkFreeMemory(device, modelBuffersMemory[i], nullptr);
+    if (!mapped) {
+        stagingRing.upload(buffer, offset, data, size);
+        return;
+    }
 
-        vkDestroyBuffer(device, modelDataBuffers[i], nullptr);
-        vkFreeMemory(device, modelDataBuffersMemory[i], nullptr);
+    memcpy(static_cast<char*>(mapped) + offset, data, size);
 
-        vkDestroyBuffer(device, atomicCounterBuffers[i], nullptr);
-        vkFreeMemory(device, atomicCounterBuffersMemory[i], nullptr);
+    for (const auto& retired : retiredBuffers) {
+        if (retired.successor != mapped || offset >= retired.size) continue;
 
-        vkDestroyBuffer(device, visibleIndicesBuffers[i], nullptr);
-        vkFreeMemory(device, visibleIndicesBuffersMemory[i], nullptr);
+        memcpy(static_cast<char*>(retired.memory.mapped) + offset, data, std::min<size_t>(size, retired.size - offset));
+    }
+}
+void BufferManager::writeAll(const std::vector<VkBuffer>& buffers, const std::vector<void*>& buffersMapped, const size_t offset, const void* data, const size_t size) {
+    if (size == 0) return;
 
-        vkDestroyBuffer(device, uniformCullingBuffers[i], nullptr);
-        vkFreeMemory(device, uniformCullingBuffersMemory[i], nullptr);
+    if (!buffersMapped[0]) {
+        const VkDeviceSize staged = stagingRing.stage(data, size);
+        for (const VkBuffer buffer : buffers) {
+            stagingRing.copy(buffer, offset, staged, size);
+        }
+        return;
+    }
 
-        vkDestroyBuffer(device, uniformPostprocessingBuffers[i], nullptr);
-        vkFreeMemory(device, uniformPostprocessingBuffersMemory[i], nullptr);
+    for (size_t i = 0; i < buffers.size(); i++) {
+        write(buffers[i], buffersMapped[i], offset, data, size);
     }
+}
+#pragma endregion
+
+void BufferManager::createBuffers() {
+    BuffersRegistry::createVertexBuffer(device, physicalDevice, uploadService, vertexBuffer, vertexBufferMemory, *modelEntityManager);
+    BuffersRegistry::createIndexBuffer(device, physicalDevice, uploadService, indexBuffer, indexBufferMemory, *modelEntityManager);
+    BuffersRegistry::createMaterialBuffer(device, physicalDevice, uploadService, materialConstant, materialBuffer, materialBufferMemory, *modelEntityManager);
+
 
-    vkDestroyBuffer(device, modelCullingBuffer, nullptr);
-    vkFreeMemory(device, modelCullingBufferMemory, nullptr);
+    // Generic
+    BuffersRegistry::createGenericBuffers(device, physicalDevice, uniformConstants, uniformBuffers, uniformBuffersMemory, uniformBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(UniformBuffer), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    BuffersRegistry::createGenericBuffers(device, physicalDevice, uniformMatrixConstants, uniformMatrixBuffers, uniformMatrixBuffersMemory, uniformMatrixBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(UniformBuffer), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    BuffersRegistry::createGenericBuffers(device, physicalDevice, uniformPostprocessingConstants, uniformPostprocessingBuffers, uniformPostprocessingBuffersMemory, uniformPostprocessingBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(uniformPostprocessingBufferObject), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    BuffersRegistry::createGenericBuffers(device, physicalDevice, atomicCounterConstants, atomicCounterBuffers, atomicCounterBuffersMemory, atomicCounterBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(AtomicCounterBuffer), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    cullingValidation.initialize(MAX_FRAMES_IN_FLIGHT);
+
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    cpuCulling = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+
+    // Matrices
+    directWrites = allowResizableBar && GpuAllocator::supportsResizableBar(physicalDevice);
+    hostWrittenMemory = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | (directWrites ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : 0);
+    stagingRing.initialize(device, physicalDevice, MAX_FRAMES_IN_FLIGHT + 1);
 
-    vkDestroyBuffer(device, vertexBuffer, nullptr);
-    vkFreeMemory(device, vertexBufferMemory, nullptr);
+    instanceCapacity = static_cast<uint32_t>(std::max<size_t>(MIN_INSTANCE_CAPACITY, std::bit_ceil(modelEntityManager->getTotalInstanceCount())));
+    modelCapacity = static_cast<uint32_t>(std::max<size_t>(MIN_MODEL_CAPACITY, std::bit_ceil(modelEntityManager->regions.size())));
 
-    vkDestroyBuffer(device, indexBuffer, nullptr);
-    vkFreeMemory(device, indexBufferMemory, nullptr);
+    BuffersRegistry::createGenericBuffers(device, physicalDevice, modelConstants, modelBuffers, modelBuffersMemory, modelBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(glm::mat4) * instanceCapacity, GROWABLE_USAGE, hostWrittenMemory);
+    BuffersRegistry::createGenericBuffers(device, physicalDevice, modelDataConstants, modelDataBuffers, modelDataBuffersMemory, modelDataBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(glm::vec4) * 3 * instanceCapacity, GROWABLE_USAGE, hostWrittenMemory);
 
-    vkDestroyBuffer(device, textureIndexBuffer, nullptr);
-    vkFreeMemory(device, textureIndexBufferMemory, nullptr);
+    // Culling
+    BuffersRegistry::createGenericBuffers(device, physicalDevice, uniformCullingConstants, uniformCullingBuffers, uniformCullingBuffersMemory, uniformCullingBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(UniformCullingBuffer), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    BuffersRegistry::createGenericBuffers(device, physicalDevice, visibleIndicesConstants, visibleIndicesBuffers, visibleIndicesBuffersMemory, visibleIndicesBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(uint32_t) * instanceCapacity, GROWABLE_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    BuffersRegistry::createGenericBuffer(device, physicalDevice, modelCullingConstant, modelCullingBuffer, modelCullingBufferMemory, modelCullingBufferMapped, sizeof(CullingData) * instanceCapacity, GROWABLE_USAGE, hostWrittenMemory);
+    BuffersRegistry::createGenericBuffers(device, physicalDevice, lateVisibleIndicesConstants, lateVisibleIndicesBuffers, lateVisibleIndicesBuffersMemory, lateVisibleIndicesBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(uint32_t) * instanceCapacity, GROWABLE_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    BuffersRegistry::createGenericBuffer(device, physicalDevice, visibilityConstant, visibilityBuffer, visibilityBufferMemory, visibilityBufferMapped, sizeof(uint32_t) * instanceCapacity, GROWABLE_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    BuffersRegistry::createGenericBuffers(device, physicalDevice, impostorConstants, impostorBuffers, impostorBuffersMemory, impostorBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(ImpostorList) + sizeof(uint32_t) * instanceCapacity, DRAW_COMMANDS_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+
+    // Draw commands shenanigans
+    updateDrawCommands();
+    BuffersRegistry::createGenericBuffers(device, physicalDevice, drawCommandsSourceConstants, drawCommandsSourceBuffers, drawCommandsSourceBuffersMemory, drawCommandsSourceBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(VkDrawIndexedIndirectCommand) * modelCapacity, DRAW_COMMANDS_USAGE, hostWrittenMemory);
+    BuffersRegistry::createGenericBuffers(device, physicalDevice, drawCommandsConstants, drawCommandsBuffers, drawCommandsBuffersMemory, drawCommandsBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(VkDrawIndexedIndirectCommand) * modelCapacity, DRAW_COMMANDS_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    BuffersRegistry::createGenericBuffers(device, physicalDevice, compactedDrawCommandsConstants, compactedDrawCommandsBuffers, compactedDrawCommandsBuffersMemory, compactedDrawCommandsBuffersMapped, MAX_FRAMES_IN_FLIGHT, sizeof(CompactedDrawCommand) * 2 * modelCapacity, DRAW_COMMANDS_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    {
+        // Instance counts start at zero, culling counts them up and compaction clears them again
+        std::vector<VkDrawIndexedIndirectCommand> commands = drawCommandsSourceObject.commands;
+        for (auto& command : commands) command.instanceCount = 0;
+
+        std::lock_guard lock(uploadMutex);
+        writeAll(drawCommandsSourceBuffers, drawCommandsSourceBuffersMapped, 0, commands.data(), sizeof(VkDrawIndexedIndirectCommand) * commands.size());
+        writeAll(drawCommandsBuffers, drawCommandsBuffersMapped, 0, commands.data(), sizeof(VkDrawIndexedIndirectCommand) * commands.size());
+    }
+
+    initializeModelBuffer();
+}
+
+void BufferManager::cleanup() const {
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        BuffersRegistry::destroyBuffer(device, uniformBuffers[i], uniformBuffersMemory[i]);
+        BuffersRegistry::destroyBuffer(device, uniformMatrixBuffers[i], uniformMatrixBuffersMemory[i]);
+        BuffersRegistry::destroyBuffer(device, modelBuffers[i], modelBuffersMemory[i]);
+        BuffersRegistry::destroyBuffer(device, modelDataBuffers[i], modelDataBuffersMemory[i]);
+        BuffersRegistry::destroyBuffer(device, atomicCounterBuffers[i], atomicCounterBuffersMemory[i]);
+        BuffersRegistry::destroyBuffer(device, visibleIndicesBuffers[i], visibleIndicesBuffersMemory[i]);
+        BuffersRegistry::destroyBuffer(device, lateVisibleIndicesBuffers[i], lateVisibleIndicesBuffersMemory[i]);
+        BuffersRegistry::destroyBuffer(device, impostorBuffers[i], impostorBuffersMemory[i]);
+        BuffersRegistry::destroyBuffer(device, drawCommandsSourceBuffers[i], drawCommandsSourceBuffersMemory[i]);
+        BuffersRegistry::destroyBuffer(device, drawCommandsBuffers[i], drawCommandsBuffersMemory[i]);
+        BuffersRegistry::destroyBuffer(device, compactedDrawCommandsBuffers[i], compactedDrawCommandsBuffersMemory[i]);
+        BuffersRegistry::destroyBuffer(device, uniformCullingBuffers[i], uniformCullingBuffersMemory[i]);
+        BuffersRegistry::destroyBuffer(device, uniformPostprocessingBuffers[i], uniformPostprocessingBuffersMemory[i]);
+    }
+
+    BuffersRegistry::destroyBuffer(device, modelCullingBuffer, modelCullingBufferMemory);
+    BuffersRegistry::destroyBuffer(device, visibilityBuffer, visibilityBufferMemory);
+    depthPyramid.cleanup(device);
+    impostorAtlas.cleanup(device);
+    cullingValidation.cleanup(device);
+    BuffersRegistry::destroyBuffer(device, vertexBuffer, vertexBufferMemory);
+    BuffersRegistry::destroyBuffer(device, indexBuffer, indexBufferMemory);
+    BuffersRegistry::destroyBuffer(device, materialBuffer, materialBufferMemory);
+
+    for (const auto& retired : retiredBuffers) {
+        BuffersRegistry::destroyBuffer(device, retired.buffer, retired.memory);
+    }
 
-    vkDestroyBuffer(device, textureIndexOffsetBuffer, nullptr);
-    vkFreeMemory(device, textureIndexOffsetBufferMemory, nullptr);
+    stagingRing.cleanup();
+    uploadService.cleanup();
 }
@@ -7,7 +7,16 @@
 
 
 
+#include <mutex>
 #include <string>
+#include "CullingValidation.hpp"
+#include "DepthPyramid.hpp"
+#include "DirtyRanges.hpp"
+#include "GpuAllocator.hpp"
+#include "ImpostorAtlas.hpp"
+#include "ShaderSpecialization.hpp"
+#include "StagingRing.hpp"
+#include "UploadService.hpp"
 #include "Types.hpp"
 
 struct SwapchainManager;
@@ -55,95 +64,176 @@ struct BufferManager {
     VisibleIndicesBuffer visibleIndicesObject{};
     matrixCullingBuffer matCullingBufferObject{};
 
-    // Texture index
-    TextureIndexOffsetBuffer TextureIndexOffsetBufferObject{};
-    TextureIndexBuffer textureIndexBufferObject{};
-
     // BuffersRegistry
     // Main
     std::vector<VkCommandBuffer> commandBuffers{};
 
     VkBuffer vertexBuffer{};
-    VkDeviceMemory vertexBufferMemory{};
+    GpuAllocation vertexBufferMemory{};
 
     VkBuffer indexBuffer{};
-    VkDeviceMemory indexBufferMemory{};
+    GpuAllocation indexBufferMemory{};
 
-    VkBuffer stagingBuffer{};
-    VkDeviceMemory stagingBufferMemory{};
+    // Texture slot per vertex, resolved per primitive at load time
+    VkBuffer materialBuffer{};
+    GpuAllocation materialBufferMemory{};
+    uint64_t materialConstant{};
 
     std::vector<VkBuffer> drawCommandsSourceBuffers;
-    std::vector<VkDeviceMemory> drawCommandsSourceBuffersMemory;
+    std::vector<GpuAllocation> drawCommandsSourceBuffersMemory;
     std::vector<void*> drawCommandsSourceBuffersMapped{};
     std::vector<uint64_t> drawCommandsSourceConstants;
 
     std::vector<VkBuffer> drawCommandsBuffers;
-    std::vector<VkDeviceMemory> drawCommandsBuffersMemory;
+    std::vector<GpuAllocation> drawCommandsBuffersMemory;
     std::vector<void*> drawCommandsBuffersMapped{};
     std::vector<uint64_t> drawCommandsConstants;
 
+    // Non-empty commands of both culling phases, the early list first and the late one modelCapacity entries in.
+    // Their counts are in atomicCounterBuffers
+    std::vector<VkBuffer> compactedDrawCommandsBuffers;
+    std::vector<GpuAllocation> compactedDrawCommandsBuffersMemory;
+    std::vector<void*> compactedDrawCommandsBuffersMapped{};
+    std::vector<uint64_t> compactedDrawCommandsConstants;
+
     // Generic
     std::vector<VkBuffer> uniformBuffers{};
-    std::vector<VkDeviceMemory> uniformBuffersMemory{};
+    std::vector<GpuAllocation> uniformBuffersMemory{};
     std::vector<void*> uniformBuffersMapped{};
     std::vector<uint64_t> uniformConstants{};
 
     std::vector<VkBuffer> uniformMatrixBuffers{};
-    std::vector<VkDeviceMemory> uniformMatrixBuffersMemory{};
+    std::vector<GpuAllocation> uniformMatrixBuffersMemory{};
     std::vector<void*> uniformMatrixBuffersMapped{};
     std::vector<uint64_t> uniformMatrixConstants{};
 
     std::vector<VkBuffer> uniformPostprocessingBuffers{};
-    std::vector<VkDeviceMemory> uniformPostprocessingBuffersMemory{};
+    std::vector<GpuAllocation> uniformPostprocessingBuffersMemory{};
     std::vector<void*> uniformPostprocessingBuffersMapped{};
     std::vector<uint64_t> uniformPostprocessingConstants{};
 
     std::vector<VkBuffer> uniformCullingBuffers{};
-    std::vector<VkDeviceMemory> uniformCullingBuffersMemory{};
+    std::vector<GpuAllocation> uniformCullingBuffersMemory{};
     std::vector<void*> uniformCullingBuffersMapped{};
     std::vector<uint64_t> uniformCullingConstants{};
 
     std::vector<VkBuffer> atomicCounterBuffers{};
-    std::vector<VkDeviceMemory> atomicCounterBuffersMemory{};
+    std::vector<GpuAllocation> atomicCounterBuffersMemory{};
     std::vector<void*> atomicCounterBuffersMapped{};
     std::vector<uint64_t> atomicCounterConstants{};
 
 
     // Matrices
     std::vector<VkBuffer> modelBuffers{};
-    std::vector<VkDeviceMemory> modelBuffersMemory{};
+    std::vector<GpuAllocation> modelBuffersMemory{};
     std::vector<void*> modelBuffersMapped{};
     std::vector<uint64_t> modelConstants{};
 
     std::vector<VkBuffer> modelDataBuffers{};
-    std::vector<VkDeviceMemory> modelDataBuffersMemory{};
+    std::vector<GpuAllocation> modelDataBuffersMemory{};
     std::vector<void*> modelDataBuffersMapped{};
     std::vector<uint64_t> modelDataConstants{};
 
 
     // Culling
     std::vector<VkBuffer> visibleIndicesBuffers{};
-    std::vector<VkDeviceMemory> visibleIndicesBuffersMemory{};
+    std::vector<GpuAllocation> visibleIndicesBuffersMemory{};
     std::vector<void*> visibleIndicesBuffersMapped{};
     std::vector<uint64_t> visibleIndicesConstants{};
 
+    // Instances the late culling phase found, drawn with drawCommandsBuffers
+    std::vector<VkBuffer> lateVisibleIndicesBuffers{};
+    std::vector<GpuAllocation> lateVisibleIndicesBuffersMemory{};
+    std::vector<void*> lateVisibleIndicesBuffersMapped{};
+    std::vector<uint64_t> lateVisibleIndicesConstants{};
+
+    // Per instance, whether it passed the occlusion test last frame. Only decides which phase draws it
+    VkBuffer visibilityBuffer{};
+    GpuAllocation visibilityBufferMemory{};
+    void* visibilityBufferMapped{};
+    uint64_t visibilityConstant{};
+
+    DepthPyramid depthPyramid{};
+
+    // ImpostorList of the early culling phase
+    std::vector<VkBuffer> impostorBuffers{};
+    std::vector<GpuAllocation> impostorBuffersMemory{};
+    std::vector<void*> impostorBuffersMapped{};
+    std::vector<uint64_t> impostorConstants{};
+
+    ImpostorAtlas impostorAtlas{};
+
+    float minPixelRadius = 0.5f; // Instances covering less than this are skipped
+    float impostorDistance = 512.0f; // Instances past this view depth are drawn as impostors, 0 draws meshes only
+    bool culling = true; // Off draws every instance as a mesh. Both are read once, when the culling pipeline is specialized
+
     VkBuffer modelCullingBuffer{};
-    VkDeviceMemory modelCullingBufferMemory{};
+    GpuAllocation modelCullingBufferMemory{};
     void* modelCullingBufferMapped{};
     uint64_t modelCullingConstant{};
 
-    // Index
-    VkBuffer textureIndexBuffer{};
-    VkDeviceMemory textureIndexBufferMemory{};
-    void* textureIndexBufferMapped{};
-    uint64_t textureIndexConstant{};
+    static inline bool modelBufferInitialized = false;
+
+    // Software drivers run the culling shader on the cpu anyway, FrustumCuller does the same job without the dispatch
+    bool cpuCulling = false;
 
-    VkBuffer textureIndexOffsetBuffer{};
-    VkDeviceMemory textureIndexOffsetBufferMemory{};
-    void* textureIndexOffsetBufferMapped{};
-    uint64_t textureIndexOffsetConstant{};
+    CullingValidation cullingValidation{}; // Debug builds only
 
-    static inline bool modelBufferInitialized = false;
+    // Instances waiting for an upload, per buffer
+    static constexpr size_t UPLOAD_GAP = 64; // Clean instances between two ranges that are cheaper to upload than to skip
+    static constexpr size_t MAX_UPLOAD_REGIONS = 16;
+
+    std::vector<DirtyRanges> modelDataRanges{}; // Per frame
+    DirtyRanges modelRanges{}; // Same for every frame, staged once
+    DirtyRanges cullingRanges{};
+    #pragma endregion
+
+    #pragma region Growth
+    // Per instance and per model buffers start at these and double whenever the scene outgrows them
+    static constexpr uint32_t MIN_INSTANCE_CAPACITY = 2048;
+    static constexpr uint32_t MIN_MODEL_CAPACITY = 1024;
+
+    static constexpr int GROWABLE_USAGE = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT;
+    static constexpr int DRAW_COMMANDS_USAGE = GROWABLE_USAGE | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+    // Replaced by a bigger buffer, destroyed once the frame that copied it out passed on the frame timeline
+    struct RetiredBuffer {
+        static constexpr uint64_t PENDING = UINT64_MAX;
+
+        VkBuffer buffer{};
+        GpuAllocation memory{};
+        VkDeviceSize size = 0;
+        void* successor = nullptr; // Mapped replacement, host writes to it are mirrored here so the pending copy doesn't undo them
+        uint64_t lastUse = PENDING; // Frame timeline value of the submit that recorded the copy
+    };
+
+    struct BufferCopy {
+        VkBuffer src{};
+        VkBuffer dst{};
+        VkDeviceSize size = 0;
+    };
+
+    uint32_t instanceCapacity = 0;
+    uint32_t modelCapacity = 0;
+
+    std::vector<RetiredBuffer> retiredBuffers{};
+    std::vector<BufferCopy> pendingCopies{};
+    #pragma endregion
+
+    #pragma region Uploads
+    // Instance data lives in device local memory, host writes go through the staging ring.
+    // With resizable BAR it can be host visible too and written in place instead
+    bool allowResizableBar = false;
+    bool directWrites = false;
+    int hostWrittenMemory = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    StagingRing stagingRing{};
+
+    // One-off uploads of static data (meshes, textures) on the transfer queue
+    UploadService uploadService{};
+
+    // Physics streams matrices from the tick thread while the render thread stages, grows and records
+    static inline std::mutex uploadMutex{};
     #pragma endregion
 
 
@@ -161,6 +251,9 @@ struct BufferManager {
     void updateCullingUniformBuffer(uint32_t currentFrame);
 
 
+    // Turns changed instances into upload ranges for every buffer holding them
+    void updateDirtyRanges();
+
     // Matrices
     void updateModelDataBuffer(uint32_t currentFrame);
 
@@ -175,14 +268,48 @@ struct BufferManager {
     // Culling
     void updateModelCullingBuffer();
 
+    // Culls on the host and uploads this frame's visible indices and draw commands, replaces the culling dispatch
+    void cullOnCpu(uint32_t currentFrame, const ShaderSpecialization& specialization);
+
+    // Checks what the gpu culled the last time this frame slot was used and prepares the host result for this frame
+    void validateCulling(uint32_t currentFrame, const ShaderSpecialization& specialization);
+
     void updateVisibleIndicesBuffer();
 
     void updateDrawCommands();
+    #pragma endregion
+
+    #pragma region Growth
+    // Grows every buffer that can't hold the counts, returns true if anything was reallocated
+    bool reserve(size_t instances, size_t models);
+
+    // Destroys retired buffers whose last use is at or below the completed frame timeline value
+    void beginFrame(uint64_t completedValue);
+
+    // Growth copies, then staged writes, has to be the first thing in the frame's command buffer.
+    // submitValue is the frame timeline value the command buffer's submit signals
+    void recordUploads(VkCommandBuffer commandBuffer, uint64_t submitValue);
+
+    void growBuffer(
+        uint64_t& constant, VkBuffer& buffer, GpuAllocation& bufferMemory, void*& bufferMapped,
+        VkDeviceSize oldSize, VkDeviceSize newSize, int usageFlags, int memoryFlags, bool preserve
+        );
+
+    void growBuffers(
+        std::vector<uint64_t>& constants, std::vector<VkBuffer>& buffers, std::vector<GpuAllocation>& buffersMemory, std::vector<void*>& buffersMapped,
+        VkDeviceSize oldSize, VkDeviceSize newSize, int usageFlags, int memoryFlags, bool preserve
+        );
+    #pragma endregion
+
+    #pragma region Uploads
+    // Host write into an instance buffer, staged unless it's mapped. uploadMutex has to be held
+    void write(VkBuffer buffer, void* mapped, size_t offset, const void* data, size_t size);
 
-    void updateTextureIndexBuffer();
+    // Same bytes into every frame's buffer, staged once
+    void writeAll(const std::vector<VkBuffer>& buffers, const std::vector<void*>& buffersMapped, size_t offset, const void* data, size_t size);
     #pragma endregion
 
-    void createBuffers(VkQueue graphicsQueue, VkCommandPool graphicsCommandPool);
+    void createBuffers();
 
     void cleanup() const;
 };
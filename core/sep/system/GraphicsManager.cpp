@@ -17,12 +17,17 @@
 #include "SwapchainManager.hpp"
 #include "ModelEntityManager.hpp"
 #include "BufferManager.hpp"
+#include "CompactPushConstants.hpp"
 #include "CullingPushConstants.hpp"
+#include "ImpostorPushConstants.hpp"
 #include "Descriptor.hpp"
+#include "Helper.hpp"
 #include "imgui_internal.h"
+#include "Logger.hpp"
 #include "MatrixPushConstants.hpp"
 #include "ModelBus.hpp"
 #include "PipelineCreation.hpp"
+#include "ShaderArchive.hpp"
 #include "Sync.hpp"
 #include "Tools.hpp"
 
@@ -86,6 +91,9 @@ void GraphicsManager::drawImGui(const VkCommandBuffer& commandBuffer) {
         ImGui::EndTable();
     }
 
+    ImGui::DragFloat("Min pixel radius", &bufferManager->minPixelRadius, 0.05f, 0.0f, 16.0f);
+    ImGui::DragFloat("Impostor distance", &bufferManager->impostorDistance, 1.0f, 0.0f, 4096.0f);
+
     const std::string selectedShader1 = selectedShader;
     if (ImGui::BeginCombo("shaders", selectedShader1.c_str())) {
         for (const std::string& shader : postprocessPipelines | std::views::keys) {
@@ -111,7 +119,188 @@ void GraphicsManager::drawImGui(const VkCommandBuffer& commandBuffer) {
     ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
 }
 
-void GraphicsManager::recordCommandBuffer(VkPipeline postprocessPipeline, uint32_t imageIndex) {
+void GraphicsManager::recordCulling(VkCommandBuffer& commandBuffer, const uint32_t phase) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullingComputePipeline);
+
+    CullingPushConstants cullingConstants{};
+    cullingConstants.mcb = bufferManager->modelCullingConstant;
+    cullingConstants.vib = bufferManager->visibleIndicesConstants[currentFrame];
+    cullingConstants.dcsb = bufferManager->drawCommandsSourceConstants[currentFrame];
+    cullingConstants.dcb = bufferManager->drawCommandsConstants[currentFrame];
+    cullingConstants.ucbo = bufferManager->uniformCullingConstants[currentFrame];
+    cullingConstants.counter = bufferManager->atomicCounterConstants[currentFrame];
+    cullingConstants.impostors = bufferManager->impostorConstants[currentFrame];
+    cullingConstants.lateVib = bufferManager->lateVisibleIndicesConstants[currentFrame];
+    cullingConstants.visibility = bufferManager->visibilityConstant;
+    cullingConstants.pyramid = bufferManager->depthPyramid.constant;
+    cullingConstants.phase = phase;
+
+    vkCmdPushConstants(
+    commandBuffer,
+        cullingComputePipelineLayout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(CullingPushConstants),
+        &cullingConstants
+        );
+
+    vkCmdDispatch(commandBuffer, specialization.groupCount(modelEntityManager->getTotalInstanceCount()), 1, 1);
+
+    const bool late = phase == CULLING_PHASE_LATE;
+    VkBuffer& commands = late ? bufferManager->drawCommandsBuffers[currentFrame] : bufferManager->drawCommandsSourceBuffers[currentFrame];
+
+    Barrier culled(commandBuffer);
+    culled.buffer(
+        late ? bufferManager->lateVisibleIndicesBuffers[currentFrame] : bufferManager->visibleIndicesBuffers[currentFrame],
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+        0, VK_WHOLE_SIZE
+    ).buffer(
+        commands,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        0, VK_WHOLE_SIZE
+    );
+
+    // Impostors only come out of the early phase
+    if (!late) {
+        culled.buffer(
+            bufferManager->impostorBuffers[currentFrame],
+            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+            VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+            0, VK_WHOLE_SIZE
+        );
+    }
+
+    // Visibility written by the late phase is read by the next frame's early one
+    if (late) {
+        culled.buffer(
+            bufferManager->visibilityBuffer,
+            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+            VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            0, VK_WHOLE_SIZE
+        );
+    }
+
+    culled.apply();
+
+    // Only the non-empty commands go on to the draw
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, compactComputePipeline);
+
+    const auto commandCount = static_cast<uint32_t>(modelEntityManager->getTotalModelCount());
+
+    CompactPushConstants compactConstants{};
+    compactConstants.commands = late ? bufferManager->drawCommandsConstants[currentFrame] : bufferManager->drawCommandsSourceConstants[currentFrame];
+    compactConstants.compacted = bufferManager->compactedDrawCommandsConstants[currentFrame] + compactedOffset(phase);
+    compactConstants.counter = bufferManager->atomicCounterConstants[currentFrame] + sizeof(uint32_t) * phase;
+    compactConstants.commandCount = commandCount;
+
+    vkCmdPushConstants(commandBuffer, compactComputePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CompactPushConstants), &compactConstants);
+
+    vkCmdDispatch(commandBuffer, specialization.groupCount(commandCount), 1, 1);
+
+    // Cleared instance counts are next counted up by this frame slot's next culling
+    Barrier compacted(commandBuffer);
+    compacted.buffer(
+        bufferManager->compactedDrawCommandsBuffers[currentFrame],
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+        compactedOffset(phase), sizeof(CompactedDrawCommand) * bufferManager->modelCapacity
+    ).buffer(
+        bufferManager->atomicCounterBuffers[currentFrame],
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+        0, VK_WHOLE_SIZE
+    ).buffer(
+        commands,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        0, VK_WHOLE_SIZE
+    ).apply();
+}
+
+VkDeviceSize GraphicsManager::compactedOffset(const uint32_t phase) const {
+    return sizeof(CompactedDrawCommand) * bufferManager->modelCapacity * phase;
+}
+
+void GraphicsManager::drawScene(VkCommandBuffer& commandBuffer, const uint32_t phase, const uint64_t visibleIndices) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelineLayout, 0, 1, &graphicsDescriptorSets[currentFrame], 0, nullptr);
+
+    VertexPushConstants vertexConstants{};
+    vertexConstants.ubo = bufferManager->uniformConstants[currentFrame];
+    vertexConstants.mb = bufferManager->modelConstants[currentFrame];
+    vertexConstants.vib = visibleIndices;
+    vertexConstants.materials = bufferManager->materialConstant;
+
+    vkCmdPushConstants(
+    commandBuffer,
+    graphicsPipelineLayout,
+        VK_SHADER_STAGE_VERTEX_BIT,
+        0,
+        sizeof(VertexPushConstants),
+        &vertexConstants
+        );
+
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(swapchainManager->swapchainExtent.width);
+    viewport.height = static_cast<float>(swapchainManager->swapchainExtent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+    VkRect2D scissor{};
+    scissor.offset = {0, 0};
+    scissor.extent = swapchainManager->swapchainExtent;
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+    VkBuffer vertexBuffers[] = {bufferManager->vertexBuffer};
+    VkDeviceSize offsets[] = {0};
+
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+
+    vkCmdBindIndexBuffer(commandBuffer, bufferManager->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+    vkCmdDrawIndexedIndirectCount(
+        commandBuffer,
+        bufferManager->compactedDrawCommandsBuffers[currentFrame], compactedOffset(phase),
+        bufferManager->atomicCounterBuffers[currentFrame], sizeof(uint32_t) * phase,
+        static_cast<uint32_t>(modelEntityManager->getTotalModelCount()), sizeof(CompactedDrawCommand)
+        );
+}
+
+void GraphicsManager::drawImpostors(VkCommandBuffer& commandBuffer) {
+    const ImpostorAtlas& atlas = bufferManager->impostorAtlas;
+    if (!atlas.baked || atlas.rows == 0) return;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, impostorPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, impostorPipelineLayout, 0, 1, &graphicsDescriptorSets[currentFrame], 0, nullptr);
+
+    ImpostorPushConstants impostorConstants{};
+    impostorConstants.ubo = bufferManager->uniformConstants[currentFrame];
+    impostorConstants.mb = bufferManager->modelConstants[currentFrame];
+    impostorConstants.mcb = bufferManager->modelCullingConstant;
+    impostorConstants.impostors = bufferManager->impostorConstants[currentFrame];
+    impostorConstants.atlasSlot = atlas.slot;
+    impostorConstants.views = ImpostorAtlas::VIEWS;
+    impostorConstants.rows = atlas.rows;
+
+    vkCmdPushConstants(commandBuffer, impostorPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ImpostorPushConstants), &impostorConstants);
+
+    // Viewport and scissor are still the scene's
+    vkCmdDrawIndirect(commandBuffer, bufferManager->impostorBuffers[currentFrame], 0, 1, sizeof(VkDrawIndirectCommand));
+}
+
+void GraphicsManager::recordCommandBuffer(VkPipeline postprocessPipeline, uint32_t imageIndex, uint64_t submitValue) {
     VkCommandBuffer& commandBuffer = bufferManager->commandBuffers[currentFrame];
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -121,11 +310,43 @@ void GraphicsManager::recordCommandBuffer(VkPipeline postprocessPipeline, uint32
         throw std::runtime_error("failed to begin recording command buffer!");
     }
 
+    uploadTicket = bufferManager->uploadService.acquire(commandBuffer);
+    bufferManager->recordUploads(commandBuffer, submitValue);
 
     #pragma region Cleanup
-    vkCmdFillBuffer(commandBuffer, bufferManager->atomicCounterBuffers[currentFrame], 0, sizeof(uint32_t), 0); // Clear atomic counter
-    for (int i = 0; i < modelEntityManager->getTotalModelCount(); i++) {
-        vkCmdFillBuffer(commandBuffer, bufferManager->drawCommandsSourceBuffers[currentFrame], offsetof(VkDrawIndexedIndirectCommand, instanceCount) + sizeof(VkDrawIndexedIndirectCommand) * i, 4, 0); // Clear 4 bites with offset of 4
+    if (!bufferManager->cpuCulling) {
+        // Instance counts are cleared by the compaction that read them, only the draw counts are left
+        vkCmdFillBuffer(commandBuffer, bufferManager->atomicCounterBuffers[currentFrame], 0, VK_WHOLE_SIZE, 0);
+
+        // Six vertices per quad, culling counts the instances up
+        constexpr VkDrawIndirectCommand impostorCommand{6, 0, 0, 0};
+        vkCmdUpdateBuffer(commandBuffer, bufferManager->impostorBuffers[currentFrame], 0, sizeof(impostorCommand), &impostorCommand);
+
+        Barrier cleared(commandBuffer);
+        cleared.buffer(
+            bufferManager->atomicCounterBuffers[currentFrame],
+            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            0, VK_WHOLE_SIZE
+        ).buffer(
+            bufferManager->impostorBuffers[currentFrame],
+            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            0, sizeof(VkDrawIndirectCommand)
+        ).apply();
+    }
+    #pragma endregion
+
+    // Once, textures are resident by the first frame
+    #pragma region impostorBake
+    if (!bufferManager->impostorAtlas.baked) {
+        bufferManager->impostorAtlas.record(
+            commandBuffer,
+            graphicsPipeline, graphicsPipelineLayout, graphicsDescriptorSets[currentFrame],
+            bufferManager->vertexBuffer, bufferManager->indexBuffer, bufferManager->materialConstant
+            );
     }
     #pragma endregion
 
@@ -144,7 +365,6 @@ void GraphicsManager::recordCommandBuffer(VkPipeline postprocessPipeline, uint32
     static size_t frame = 0;
 
     if (matrixDirty) {
-        constexpr uint32_t workgroupSize = 128;
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, matrixComputePipeline);
 
         MatrixPushConstants matrixConstants{};
@@ -167,10 +387,7 @@ void GraphicsManager::recordCommandBuffer(VkPipeline postprocessPipeline, uint32
             frame = 0;
         }
 
-        const size_t totalInstances = modelEntityManager->getTotalInstanceCount();
-        uint32_t groupCount = (totalInstances + workgroupSize - 1) / workgroupSize;
-
-        vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+        vkCmdDispatch(commandBuffer, specialization.groupCount(modelEntityManager->getTotalInstanceCount()), 1, 1);
         Barrier vibBarrier(commandBuffer);
         vibBarrier.buffer(
             bufferManager->modelDataBuffers[currentFrame],
@@ -183,55 +400,7 @@ void GraphicsManager::recordCommandBuffer(VkPipeline postprocessPipeline, uint32
     #pragma endregion
 
     #pragma region Culling
-    static size_t frame1 = 0;
-
-    if (frame1 % 4 == 0 || true) {
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullingComputePipeline);
-
-        CullingPushConstants cullingConstants{};
-        cullingConstants.mcb = bufferManager->modelCullingConstant;
-        cullingConstants.vib = bufferManager->visibleIndicesConstants[currentFrame];
-        cullingConstants.dcsb = bufferManager->drawCommandsSourceConstants[currentFrame];
-        cullingConstants.dcb = bufferManager->drawCommandsConstants[currentFrame];
-        cullingConstants.ucbo =bufferManager-> uniformCullingConstants[currentFrame];
-        cullingConstants.counter = bufferManager->atomicCounterConstants[currentFrame];
-
-        vkCmdPushConstants(
-        commandBuffer,
-            cullingComputePipelineLayout,
-            VK_SHADER_STAGE_COMPUTE_BIT,
-            0,
-            sizeof(CullingPushConstants),
-            &cullingConstants
-            );
-
-        constexpr uint32_t workgroupSize1 = 128;
-        const size_t totalInstances = modelEntityManager->getTotalInstanceCount();
-        uint32_t groupCount = (totalInstances + workgroupSize1 - 1) / workgroupSize1;
-
-        vkCmdDispatch(commandBuffer, groupCount, 1, 1);
-        Barrier vibBarrier(commandBuffer);
-        vibBarrier.buffer(
-            bufferManager->atomicCounterBuffers[currentFrame],
-            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-            VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
-            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
-            0, VK_WHOLE_SIZE
-        ).buffer(
-            bufferManager->visibleIndicesBuffers[currentFrame],
-            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-            VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
-            0, VK_WHOLE_SIZE
-        ).buffer(
-            bufferManager->drawCommandsSourceBuffers[currentFrame],
-            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-            VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
-            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
-            0, VK_WHOLE_SIZE
-        ).apply();
-    }
-    frame1++;
+    if (!bufferManager->cpuCulling) recordCulling(commandBuffer, CULLING_PHASE_EARLY);
     #pragma endregion
 
     // Dynamic rendering info
@@ -249,7 +418,7 @@ void GraphicsManager::recordCommandBuffer(VkPipeline postprocessPipeline, uint32
     depthAttachment.imageView = swapchainManager->depthImageView;
     depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
     depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // Read by the depth pyramid and postprocessing
     depthAttachment.clearValue.depthStencil = {1.0f, 0};
 
     VkRenderingInfo renderingInfo{};
@@ -269,7 +438,7 @@ void GraphicsManager::recordCommandBuffer(VkPipeline postprocessPipeline, uint32
     swapchainManager->depthImage,
     VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
     VK_ACCESS_2_NONE, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-    VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT,
+    VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT, // Last frame's postprocessing samples it
     VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT
     ).image(
     swapchainManager->offscreenImages[currentFrame],
@@ -284,58 +453,39 @@ void GraphicsManager::recordCommandBuffer(VkPipeline postprocessPipeline, uint32
     #pragma region offScreenRender
     vkCmdBeginRendering(commandBuffer, &renderingInfo);
 
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelineLayout, 0, 1, &graphicsDescriptorSets[currentFrame], 0, nullptr);
-
-    VertexPushConstants vertexConstants{};
-    vertexConstants.ubo = bufferManager->uniformConstants[currentFrame];
-    vertexConstants.mb = bufferManager->modelConstants[currentFrame];
-    vertexConstants.vib = bufferManager->visibleIndicesConstants[currentFrame];
-    vertexConstants.ti = bufferManager->textureIndexConstant;
-    vertexConstants.tio = bufferManager->textureIndexOffsetConstant;
+    drawScene(commandBuffer, CULLING_PHASE_EARLY, bufferManager->visibleIndicesConstants[currentFrame]);
+    drawImpostors(commandBuffer);
 
-    vkCmdPushConstants(
-    commandBuffer,
-    graphicsPipelineLayout,
-        VK_SHADER_STAGE_VERTEX_BIT,
-        0,
-        sizeof(VertexPushConstants),
-        &vertexConstants
-        );
-
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(swapchainManager->swapchainExtent.width);
-    viewport.height = static_cast<float>(swapchainManager->swapchainExtent.height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = swapchainManager->swapchainExtent;
-    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
-    VkBuffer vertexBuffers[] = {bufferManager->vertexBuffer};
-    VkDeviceSize offsets[] = {0};
-
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    vkCmdEndRendering(commandBuffer);
+    #pragma endregion
 
-    vkCmdBindIndexBuffer(commandBuffer, bufferManager->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    // Pyramid from the early depth, then whatever it doesn't hide and wasn't drawn yet
+    #pragma region occlusion
+    if (!bufferManager->cpuCulling) {
+        bufferManager->depthPyramid.record(commandBuffer, swapchainManager->depthImage, depthPyramidComputePipeline, depthPyramidComputePipelineLayout);
+        recordCulling(commandBuffer, CULLING_PHASE_LATE);
 
-    //vkCmdDrawIndexedIndirectCount(commandBuffer, bufferManager->drawCommandsSourceBuffers[currentFrame], 0, bufferManager->atomicCounterBuffers[currentFrame], 0, 1024, sizeof(VkDrawIndexedIndirectCommand));
-    //vkCmdDrawIndexedIndirect(commandBuffer, drawCommandsSourceBuffers[currentFrame], 0, static_cast<uint32_t>(mdlBus.getTotalModelCount()), sizeof(VkDrawIndexedIndirectCommand));
-    vkCmdDrawIndexedIndirect(commandBuffer, bufferManager->drawCommandsSourceBuffers[currentFrame], 0, static_cast<uint32_t>(modelEntityManager->getTotalModelCount()), sizeof(VkDrawIndexedIndirectCommand));
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
 
+        vkCmdBeginRendering(commandBuffer, &renderingInfo);
+        drawScene(commandBuffer, CULLING_PHASE_LATE, bufferManager->lateVisibleIndicesConstants[currentFrame]);
+        vkCmdEndRendering(commandBuffer);
 
-    vkCmdEndRendering(commandBuffer);
+#ifndef NDEBUG
+        bufferManager->cullingValidation.record(
+            commandBuffer, currentFrame,
+            bufferManager->impostorBuffers[currentFrame], bufferManager->atomicCounterBuffers[currentFrame], bufferManager->compactedDrawCommandsBuffers[currentFrame],
+            sizeof(CompactedDrawCommand) * 2 * bufferManager->modelCapacity
+            );
+#endif
+    }
     #pragma endregion
 
     // Transition Offscreen image layout so we can read it from shaders
     #pragma region offscreenLayoutTransition
     Barrier midBarrier(commandBuffer);
-    barrier.image(
+    midBarrier.image(
         swapchainManager->offscreenImages[currentFrame],
         VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
         VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_2_SHADER_READ_BIT,
@@ -344,8 +494,8 @@ void GraphicsManager::recordCommandBuffer(VkPipeline postprocessPipeline, uint32
         ).image(
         swapchainManager->depthImage,
         VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_2_SHADER_READ_BIT,
-        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_ACCESS_2_SHADER_READ_BIT,
+        VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
         VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT
         ).image(
         swapchainManager->swapchainImages[imageIndex],
@@ -416,41 +566,64 @@ void GraphicsManager::recordCommandBuffer(VkPipeline postprocessPipeline, uint32
     }
 }
 
-void GraphicsManager::waitForFence(VkFence fence) const {
-    Logger logger("waitForFences()");
+void GraphicsManager::waitForGpu() const {
+    Sync::waitTimeline(device, frameTimeline, frameValue);
+}
 
-    const auto result = vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+void GraphicsManager::createPresentSemaphores() {
+    // Indexed by swapchain image, acquiring an image again means its last present consumed the semaphore
+    while (renderFinishedSemaphores.size() < swapchainManager->swapchainImages.size()) {
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    if (result != VK_SUCCESS) {
-        logger.error("ERROR!");
-    } else {
-        vkResetFences(device, 1, &fence);
+        VkSemaphore semaphore;
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create semaphore!");
+        }
+        renderFinishedSemaphores.emplace_back(semaphore);
     }
 }
 
-// Create pipeline for each postprocessing shader
+// Register each postprocessing shader, only the selected one is compiled up front
 void GraphicsManager::initializePostprocessPipelines() {
-    const std::string path = Tools::getCompiledShaderPath() + "postprocessing/";
+    const std::vector<std::string> filenames = shaderArchive.list("postprocessing/");
 
-    if (!std::filesystem::exists(path) || !std::filesystem::is_directory(path)) return;
+    if (filenames.empty()) return;
 
     PipelineCreation::createPostprocessPipelineLayout(device, postprocessPipelineLayout, postprocessDescriptorSetLayout);
 
-    for (const auto& entry : std::filesystem::directory_iterator(path)) {
-        if (entry.is_regular_file()) {
-            const std::string filename = entry.path().filename().string();
-            PipelineCreation::createPostprocessPipeline(device, physicalDevice, postprocessPipelineLayout, postprocessPipelines[filename], postprocessDescriptorSetLayout, swapchainManager->swapchainImageFormat, filename);
-        }
+    for (const std::string& filename : filenames) {
+        postprocessPipelines[filename] = VK_NULL_HANDLE;
+    }
+
+    getPostprocessPipeline(selectedShader);
+}
+
+VkPipeline GraphicsManager::getPostprocessPipeline(const std::string& filename) {
+    VkPipeline& pipeline = postprocessPipelines[filename];
+    if (pipeline == VK_NULL_HANDLE) {
+        PipelineCreation::createPostprocessPipeline(device, pipelineCache.cache, shaderArchive, physicalDevice, postprocessPipelineLayout, pipeline, postprocessDescriptorSetLayout, swapchainManager->swapchainImageFormat, filename);
     }
+
+    return pipeline;
 }
 
 void GraphicsManager::initializePipelines() {
     Descriptor::createGraphicsDescriptorSetLayout(device, graphicsDescriptorSetLayout);
     Descriptor::createPostprocessDescriptorSetLayout(device, postprocessDescriptorSetLayout);
 
-    PipelineCreation::createGraphicsPipeline(device, physicalDevice, graphicsPipelineLayout, graphicsPipeline, graphicsDescriptorSetLayout, swapchainManager->swapchainImageFormat);
-    PipelineCreation::createMatrixComputePipeline(device, matrixComputePipelineLayout, matrixComputePipeline);
-    PipelineCreation::createCullingComputePipeline(device, cullingComputePipelineLayout, cullingComputePipeline);
+    pipelineCache.load(device, physicalDevice, Tools::getCompiledShaderPath() + "pipeline.cache");
+    shaderArchive.open(ShaderArchive::getPath());
+    specialization = ShaderSpecialization::forDevice(physicalDevice, bufferManager->culling, bufferManager->impostorDistance > 0.0f);
+    Logger LOGGER{"GraphicsManager"};
+    LOGGER.info("Compute workgroup size: ${}, culling: ${}, lod count: ${}", specialization.workgroupSize, specialization.culling, specialization.lodCount);
+
+    PipelineCreation::createGraphicsPipeline(device, pipelineCache.cache, shaderArchive, physicalDevice, graphicsPipelineLayout, graphicsPipeline, graphicsDescriptorSetLayout, swapchainManager->swapchainImageFormat);
+    PipelineCreation::createImpostorPipeline(device, pipelineCache.cache, shaderArchive, physicalDevice, impostorPipelineLayout, impostorPipeline, graphicsDescriptorSetLayout, swapchainManager->swapchainImageFormat);
+    PipelineCreation::createMatrixComputePipeline(device, pipelineCache.cache, shaderArchive, specialization, matrixComputePipelineLayout, matrixComputePipeline);
+    PipelineCreation::createCullingComputePipeline(device, pipelineCache.cache, shaderArchive, specialization, cullingComputePipelineLayout, cullingComputePipeline);
+    PipelineCreation::createDepthPyramidComputePipeline(device, pipelineCache.cache, shaderArchive, depthPyramidComputePipelineLayout, depthPyramidComputePipeline);
+    PipelineCreation::createCompactComputePipeline(device, pipelineCache.cache, shaderArchive, specialization, compactComputePipelineLayout, compactComputePipeline);
 
     initializePostprocessPipelines();
 
@@ -460,22 +633,33 @@ void GraphicsManager::initializePipelines() {
 
 void GraphicsManager::initializeDescriptors() {
     Descriptor::createGraphicsDescriptorPool(device, graphicsDescriptorPool, MAX_FRAMES_IN_FLIGHT);
-    Descriptor::createGraphicsDescriptorSets(device, graphicsDescriptorSetLayout, graphicsDescriptorPool, graphicsDescriptorSets, swapchainManager->textureSampler, missingnoTextureImageView, *modelEntityManager, MAX_FRAMES_IN_FLIGHT);
+    Descriptor::createGraphicsDescriptorSets(device, graphicsDescriptorSetLayout, graphicsDescriptorPool, graphicsDescriptorSets, swapchainManager->textureSampler, missingnoTextureImageView, bufferManager->impostorAtlas.view, *modelEntityManager, MAX_FRAMES_IN_FLIGHT);
 
     Descriptor::createPostprocessDescriptorPool(device, postprocessDescriptorPool, MAX_FRAMES_IN_FLIGHT);
     Descriptor::createPostprocessDescriptorSets(device, postprocessDescriptorSetLayout, postprocessDescriptorPool, postprocessDescriptorSets, swapchainManager->offscreenImageViews, swapchainManager->depthImageView, swapchainManager->textureSampler, bufferManager->uniformPostprocessingBuffers, MAX_FRAMES_IN_FLIGHT);
 
     BuffersRegistry::createCommandBuffer(device, graphicsCommandPool, bufferManager->commandBuffers, MAX_FRAMES_IN_FLIGHT);
-    Sync::createSemaphores(device, MAX_FRAMES_IN_FLIGHT, imageAvailableSemaphores, renderFinishedSemaphores);
-    Sync::createFences(device, MAX_FRAMES_IN_FLIGHT, imageFences, inFlightFences);
+    Sync::createSemaphores(device, MAX_FRAMES_IN_FLIGHT, imageAvailableSemaphores);
+    Sync::createTimelineSemaphore(device, frameTimeline);
+    frameSlotValues.assign(MAX_FRAMES_IN_FLIGHT, 0);
+    createPresentSemaphores();
 }
 
 void GraphicsManager::initializeTextures() {
     // Missingno texture
-    Images::createTextureImage(device, graphicsCommandPool, graphicsQueue, physicalDevice, bufferManager->stagingBuffer, bufferManager->stagingBufferMemory, missingnoTextureImage, missingnoTextureImageMemory, std::string{PROJECT_ROOT} + "core/textures/missingno.ktx2", VK_FORMAT_BC7_UNORM_BLOCK);
+    Images::createTextureImage(device, physicalDevice, bufferManager->uploadService, missingnoTextureImage, missingnoTextureImageMemory, std::string{PROJECT_ROOT} + "core/textures/missingno.ktx2", VK_FORMAT_BC7_UNORM_BLOCK);
     Images::createTextureImageView(device, missingnoTextureImage, missingnoTextureImageView, VK_FORMAT_BC7_UNORM_BLOCK);
 
-    ModelBus::loadModelTextures(modelEntityManager->groups, device, graphicsCommandPool, graphicsQueue, physicalDevice, bufferManager->stagingBuffer, bufferManager->stagingBufferMemory);
+    ModelBus::loadModelTextures(modelEntityManager->groups, device, physicalDevice, bufferManager->uploadService);
+
+    // Baked on the first frame, its slot is after the missing texture and every model texture
+    bufferManager->impostorAtlas.create(device, physicalDevice, *modelEntityManager, bufferManager->drawCommandsSourceObject.commands, swapchainManager->swapchainImageFormat, Helper::findDepthFormat(physicalDevice));
+
+    uint32_t textures = 0;
+    for (const auto& model : modelEntityManager->groups | std::views::transform(&ModelGroup::model)) {
+        textures += static_cast<uint32_t>(model->textures.size());
+    }
+    bufferManager->impostorAtlas.slot = 1 + textures;
 
     Images::createTextureSampler(device, physicalDevice, swapchainManager->textureSampler);
 }
@@ -576,83 +760,155 @@ void GraphicsManager::initializeImGui() {
 
 void GraphicsManager::initialize() {
     initializePipelines();
-    bufferManager->createBuffers(graphicsQueue, graphicsCommandPool);
+    bufferManager->uploadService.initialize(device, physicalDevice, swapchainManager->surface);
+    bufferManager->createBuffers();
     initializeTextures();
+    bufferManager->uploadService.flush();
     initializeDescriptors();
     initializeImGui();
+
+    // Copies, the watcher thread must not read members the render thread may change
+    shaderHotReload = std::make_unique<ShaderHotReload>();
+    shaderHotReload->start([device = device, physicalDevice = physicalDevice, cache = pipelineCache.cache, layout = postprocessPipelineLayout, descriptorSetLayout = postprocessDescriptorSetLayout, format = swapchainManager->swapchainImageFormat](const ShaderArchive& shaders, const std::string& filename) mutable {
+        VkPipeline pipeline{};
+        PipelineCreation::createPostprocessPipeline(device, cache, shaders, physicalDevice, layout, pipeline, descriptorSetLayout, format, filename);
+        return pipeline;
+    });
+}
+
+void GraphicsManager::reloadShaderArchive() {
+    shaderArchive.open(ShaderArchive::getPath());
 }
 
 void GraphicsManager::recreatePostprocessingPipeline(const std::string& filename) {
-    PipelineCreation::createPostprocessPipeline(device, physicalDevice, postprocessPipelineLayout, postprocessPipelines[filename], postprocessDescriptorSetLayout, swapchainManager->swapchainImageFormat, filename);
+    VkPipeline pipeline{};
+    PipelineCreation::createPostprocessPipeline(device, pipelineCache.cache, shaderArchive, physicalDevice, postprocessPipelineLayout, pipeline, postprocessDescriptorSetLayout, swapchainManager->swapchainImageFormat, filename);
+
+    retirePipeline(std::exchange(postprocessPipelines[filename], pipeline));
+}
+
+void GraphicsManager::swapReloadedPipelines() {
+    const uint64_t completed = Sync::timelineValue(device, frameTimeline);
+    std::erase_if(retiredPipelines, [this, completed](const std::pair<VkPipeline, uint64_t>& retired) {
+        if (retired.second > completed) return false;
+
+        vkDestroyPipeline(device, retired.first, nullptr);
+        return true;
+    });
+
+    if (!shaderHotReload) return;
+
+    Logger LOGGER{"GraphicsManager"};
+    for (auto& [filename, pipeline] : shaderHotReload->takeReady()) {
+        retirePipeline(std::exchange(postprocessPipelines[filename], pipeline));
+        LOGGER.info("Reloaded postprocessing pipeline: ${}", filename);
+    }
+}
+
+void GraphicsManager::retirePipeline(VkPipeline pipeline) {
+    // Every frame submitted so far may still be reading it
+    if (pipeline != VK_NULL_HANDLE) retiredPipelines.emplace_back(pipeline, frameValue);
 }
 
 // Draw
 void GraphicsManager::drawFrame()  {
-    waitForFence(imageFences[currentFrame]);
-    waitForFence(inFlightFences[currentFrame]);
+    // Only blocks when the gpu still holds this slot's command buffer and per frame buffers
+    Sync::waitTimeline(device, frameTimeline, frameSlotValues[currentFrame]);
+
+    swapReloadedPipelines();
 
     uint32_t imageIndex;
     VkResult result = vkAcquireNextImageKHR(device, swapchainManager->swapchain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         swapchainManager->recreateSwapchain(postprocessDescriptorSets);
+        createPresentSemaphores();
         return;
     } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         throw std::runtime_error("failed to acquire swap chain image!");
     }
 
+    bufferManager->beginFrame(Sync::timelineValue(device, frameTimeline));
+    bufferManager->uploadService.collect();
+    bufferManager->uploadService.flush();
+    bufferManager->reserve(modelEntityManager->getTotalInstanceCount(), modelEntityManager->regions.size());
+
+    // Swapchain recreation waits for the device, a new extent never pulls the pyramid from under a frame
+    bufferManager->depthPyramid.resize(device, physicalDevice, swapchainManager->swapchainExtent, Helper::findDepthFormat(physicalDevice));
+
     bufferManager->updateUniformBuffer(currentFrame);
     bufferManager->updateUniformPostprocessingBuffer(currentFrame, *delta);
     bufferManager->updateCullingUniformBuffer(currentFrame);
+    bufferManager->updateDirtyRanges();
     bufferManager->updateModelCullingBuffer();
+    if (bufferManager->cpuCulling) bufferManager->cullOnCpu(currentFrame, specialization);
+#ifndef NDEBUG
+    else bufferManager->validateCulling(currentFrame, specialization);
+#endif
     bufferManager->updateModelDataBuffer(currentFrame);
     bufferManager->updateModelBuffer();
-    bufferManager->updateTextureIndexBuffer();
 
     std::function<void(VkCommandBuffer&)> imGui = [this](const VkCommandBuffer& commandBuffer) { drawImGui(commandBuffer); };
 
-    recordCommandBuffer(postprocessPipelines[selectedShader], imageIndex);
-
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-    const VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-    constexpr VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
-
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &bufferManager->commandBuffers[currentFrame];
-
-    const VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
-
-    if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
+    const uint64_t submitValue = frameValue + 1;
+    recordCommandBuffer(getPostprocessPipeline(selectedShader), imageIndex, submitValue);
+
+    std::array<VkSemaphoreSubmitInfo, 2> waitInfos{};
+    waitInfos[0].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    waitInfos[0].semaphore = imageAvailableSemaphores[currentFrame];
+    waitInfos[0].stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+    // Uploads acquired by this frame
+    waitInfos[1].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    waitInfos[1].semaphore = bufferManager->uploadService.timeline;
+    waitInfos[1].value = uploadTicket;
+    waitInfos[1].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    std::array<VkSemaphoreSubmitInfo, 2> signalInfos{};
+    signalInfos[0].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    signalInfos[0].semaphore = renderFinishedSemaphores[imageIndex];
+    signalInfos[0].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    signalInfos[1].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    signalInfos[1].semaphore = frameTimeline;
+    signalInfos[1].value = submitValue;
+    signalInfos[1].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    VkCommandBufferSubmitInfo commandBufferInfo{};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+    commandBufferInfo.commandBuffer = bufferManager->commandBuffers[currentFrame];
+
+    VkSubmitInfo2 submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+    submitInfo.waitSemaphoreInfoCount = uploadTicket > 0 ? 2 : 1;
+    submitInfo.pWaitSemaphoreInfos = waitInfos.data();
+    submitInfo.commandBufferInfoCount = 1;
+    submitInfo.pCommandBufferInfos = &commandBufferInfo;
+    submitInfo.signalSemaphoreInfoCount = static_cast<uint32_t>(signalInfos.size());
+    submitInfo.pSignalSemaphoreInfos = signalInfos.data();
+
+    if (vkQueueSubmit2(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
 
-    VkSwapchainPresentFenceInfoKHR imageFenceInfo{};
-    imageFenceInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_PRESENT_FENCE_INFO_KHR;
-    imageFenceInfo.pFences = &imageFences[currentFrame];
-    imageFenceInfo.swapchainCount = 1;
+    frameValue = submitValue;
+    frameSlotValues[currentFrame] = submitValue;
 
     const VkSwapchainKHR swapchains[] = { swapchainManager->swapchain };
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+    presentInfo.pWaitSemaphores = &renderFinishedSemaphores[imageIndex];
     presentInfo.swapchainCount = 1;
     presentInfo.pSwapchains = swapchains;
     presentInfo.pImageIndices = &imageIndex;
-    presentInfo.pNext = &imageFenceInfo;
 
     result = vkQueuePresentKHR(presentQueue, &presentInfo);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || *framebufferResized) {
         *framebufferResized = false;
         swapchainManager->recreateSwapchain(postprocessDescriptorSets);
+        createPresentSemaphores();
     } else if (result != VK_SUCCESS) {
         throw std::runtime_error("failed to present swap chain image!");
     }
@@ -664,8 +920,7 @@ void GraphicsManager::cleanupTextures() const {
     vkDestroySampler(device, swapchainManager->textureSampler, nullptr);
     vkDestroyImageView(device, missingnoTextureImageView, nullptr);
 
-    vkDestroyImage(device, missingnoTextureImage, nullptr);
-    vkFreeMemory(device, missingnoTextureImageMemory, nullptr);
+    Images::destroyImage(device, missingnoTextureImage, missingnoTextureImageMemory);
 
     for (auto& textures : modelEntityManager->groups
         | std::views::transform(&ModelGroup::model)
@@ -673,13 +928,20 @@ void GraphicsManager::cleanupTextures() const {
     ) {
         for (const auto& texture : textures) {
             vkDestroyImageView(device, texture.textureImageView, nullptr);
-            vkDestroyImage(device, texture.textureImage, nullptr);
-            vkFreeMemory(device, texture.textureImageMemory, nullptr);
+            Images::destroyImage(device, texture.textureImage, texture.textureImageMemory);
         }
     }
 }
 
 void GraphicsManager::cleanup() const {
+    // The watcher builds pipelines against the layouts destroyed below
+    if (shaderHotReload) {
+        shaderHotReload->stop();
+        for (const auto& pipeline : shaderHotReload->takeReady() | std::views::values) {
+            vkDestroyPipeline(device, pipeline, nullptr);
+        }
+    }
+
     vkDestroyDescriptorPool(device, graphicsDescriptorPool, nullptr);
     vkDestroyDescriptorSetLayout(device, graphicsDescriptorSetLayout, nullptr);
 
@@ -687,20 +949,31 @@ void GraphicsManager::cleanup() const {
     vkDestroyDescriptorSetLayout(device, postprocessDescriptorSetLayout, nullptr);
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
-        vkDestroyFence(device, imageFences[i], nullptr);
-        vkDestroyFence(device, inFlightFences[i], nullptr);
     }
+    for (const VkSemaphore semaphore : renderFinishedSemaphores) {
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+    vkDestroySemaphore(device, frameTimeline, nullptr);
 
     vkDestroyPipeline(device, graphicsPipeline, nullptr);
     vkDestroyPipelineLayout(device, graphicsPipelineLayout, nullptr);
+    vkDestroyPipeline(device, impostorPipeline, nullptr);
+    vkDestroyPipelineLayout(device, impostorPipelineLayout, nullptr);
 
     vkDestroyPipeline(device, matrixComputePipeline, nullptr);
     vkDestroyPipelineLayout(device, matrixComputePipelineLayout, nullptr);
 
     vkDestroyPipeline(device, cullingComputePipeline, nullptr);
     vkDestroyPipelineLayout(device, cullingComputePipelineLayout, nullptr);
+    vkDestroyPipeline(device, depthPyramidComputePipeline, nullptr);
+    vkDestroyPipelineLayout(device, depthPyramidComputePipelineLayout, nullptr);
+    vkDestroyPipeline(device, compactComputePipeline, nullptr);
+    vkDestroyPipelineLayout(device, compactComputePipelineLayout, nullptr);
+
+    for (const auto& pipeline : retiredPipelines | std::views::keys) {
+        vkDestroyPipeline(device, pipeline, nullptr);
+    }
 
     for (const auto &val: postprocessPipelines | std::views::values) {
         vkDestroyPipeline(device, val, nullptr);
@@ -708,6 +981,9 @@ void GraphicsManager::cleanup() const {
 
     vkDestroyPipelineLayout(device, postprocessPipelineLayout, nullptr);
 
+    pipelineCache.save(device);
+    pipelineCache.cleanup(device);
+
     vkDestroyCommandPool(device, graphicsCommandPool, nullptr);
 
     vkDestroyCommandPool(device, matrixComputeCommandPool, nullptr);
@@ -6,12 +6,18 @@
 #define INC_2G43S_GRAPHICS_H
 
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
 #include "Color.hpp"
+#include "GpuAllocator.hpp"
+#include "PipelineCache.hpp"
+#include "ShaderArchive.hpp"
+#include "ShaderSpecialization.hpp"
+#include "ShaderHotReload.hpp"
 
 
 struct Camera;
@@ -44,6 +50,11 @@ struct GraphicsManager {
 
     bool matrixDirty = true;
 private:
+    // Every pipeline is created through it, saved on cleanup
+    PipelineCache pipelineCache{};
+    ShaderArchive shaderArchive{}; // Mapped at startup, remapped when shaders are reloaded here
+    ShaderSpecialization specialization{}; // Shape of the matrix and culling dispatches on this device
+
     // Graphics
     VkPipeline graphicsPipeline{};
     VkPipelineLayout graphicsPipelineLayout{};
@@ -53,6 +64,10 @@ private:
     std::vector<VkDescriptorSet> graphicsDescriptorSets{};
     VkDescriptorPool graphicsDescriptorPool{};
 
+    // Far band billboards from the impostor atlas
+    VkPipeline impostorPipeline{};
+    VkPipelineLayout impostorPipelineLayout{};
+
     // Matrix
     VkPipeline matrixComputePipeline{};
     VkPipelineLayout matrixComputePipelineLayout{};
@@ -63,9 +78,25 @@ private:
     VkPipelineLayout cullingComputePipelineLayout{};
     VkCommandPool cullingComputeCommandPool{};
 
+    // Culling runs twice a frame, around the depth pyramid build
+    static constexpr uint32_t CULLING_PHASE_EARLY = 0;
+    static constexpr uint32_t CULLING_PHASE_LATE = 1;
+
+    VkPipeline depthPyramidComputePipeline{};
+    VkPipelineLayout depthPyramidComputePipelineLayout{};
+
+    // Packs each phase's non-empty draw commands for vkCmdDrawIndexedIndirectCount
+    VkPipeline compactComputePipeline{};
+    VkPipelineLayout compactComputePipelineLayout{};
+
     // Graphics
     std::string selectedShader = "hdr_fog.spv";
-    std::unordered_map<std::string, VkPipeline> postprocessPipelines;
+    std::unordered_map<std::string, VkPipeline> postprocessPipelines; // Null until first selected
+
+    // Rebuilt postprocessing pipelines come from here, replaced ones are destroyed once the frame timeline
+    // passes the last frame that could have used them
+    std::unique_ptr<ShaderHotReload> shaderHotReload{};
+    std::vector<std::pair<VkPipeline, uint64_t>> retiredPipelines{};
     VkPipelineLayout postprocessPipelineLayout{};
     VkDescriptorSetLayout postprocessDescriptorSetLayout{};
 
@@ -74,18 +105,24 @@ private:
     VkCommandPool postprocessCommandPool{};
 
     std::vector<VkSemaphore> imageAvailableSemaphores{};
-    std::vector<VkSemaphore> renderFinishedSemaphores{};
-    std::vector<VkFence> inFlightFences{};
-    std::vector<VkFence> imageFences{};
+    std::vector<VkSemaphore> renderFinishedSemaphores{}; // Per swapchain image
+
+    // Graphics queue timeline, every frame submit signals the next value.
+    // A frame slot's resources are free again once the value it was last submitted with is reached
+    VkSemaphore frameTimeline{};
+    uint64_t frameValue = 0;
+    std::vector<uint64_t> frameSlotValues{};
 
     Color clear_color = Color::hex(0x9c9c9c);
 
     uint32_t currentFrame = 0;
     size_t MAX_FRAMES_IN_FLIGHT{};
 
+    uint64_t uploadTicket = 0; // Upload timeline value the frame being recorded waits for, 0 for none
+
     // Image
     VkImage missingnoTextureImage{};
-    VkDeviceMemory missingnoTextureImageMemory{};
+    GpuAllocation missingnoTextureImageMemory{};
     VkImageView missingnoTextureImageView{};
 
     #pragma region Dependencies
@@ -112,13 +149,32 @@ private:
 
     void drawImGui(const VkCommandBuffer& commandBuffer);
 
-    void recordCommandBuffer(VkPipeline postprocessPipeline, uint32_t imageIndex);
+    // Culling and compaction dispatches of one phase and the barriers its draw needs
+    void recordCulling(VkCommandBuffer& commandBuffer, uint32_t phase);
+
+    // Byte offset of a phase's list in the compacted draw commands
+    [[nodiscard]] VkDeviceSize compactedOffset(uint32_t phase) const;
 
-    void waitForFence(VkFence fence) const;
+    // Offscreen scene draw of one phase's compacted list, has to be inside the offscreen rendering
+    void drawScene(VkCommandBuffer& commandBuffer, uint32_t phase, uint64_t visibleIndices);
 
-    // Create pipeline for each postprocessing shader
+    // Every impostor of the frame in one instanced draw, inside the offscreen rendering as well
+    void drawImpostors(VkCommandBuffer& commandBuffer);
+
+    void recordCommandBuffer(VkPipeline postprocessPipeline, uint32_t imageIndex, uint64_t submitValue);
+
+    void createPresentSemaphores();
+
+    // Registers every postprocessing shader, pipelines are created when first selected
     private: void initializePostprocessPipelines();
 
+    VkPipeline getPostprocessPipeline(const std::string& filename);
+
+    // Frame boundary, swaps in hot reloaded pipelines and destroys retired ones the gpu is done with
+    void swapReloadedPipelines();
+
+    void retirePipeline(VkPipeline pipeline);
+
     void initializePipelines();
 
     void initializeDescriptors();
@@ -129,10 +185,16 @@ private:
 public:
     void initialize();
 
+    // Maps the archive compileShaders last packed, for pipelines recreated on this thread
+    void reloadShaderArchive();
+
     void recreatePostprocessingPipeline(const std::string& filename);
 
     void drawFrame();
 
+    // Waits for everything submitted to the graphics queue so far, not for the whole device
+    void waitForGpu() const;
+
     void cleanupTextures() const;
 
     void cleanup() const;
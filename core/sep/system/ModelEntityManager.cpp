@@ -84,6 +84,23 @@ std::vector<Vertex> ModelEntityManager::getAllVertices() const {
     return vertices;
 }
 
+std::vector<uint32_t> ModelEntityManager::getAllMaterials() const {
+    std::vector<uint32_t> materials{};
+
+    // Descriptor writes go over textures in the same group order, after the missing one
+    uint32_t firstSlot = 1;
+    for (const auto& model : std::views::transform(groups, &ModelGroup::model)) {
+        for (size_t i = 0; i < model->meshes.size(); ++i) {
+            const uint32_t texture = i < model->meshTextures.size() ? model->meshTextures[i] : ParsedModel::NO_TEXTURE;
+            materials.insert(materials.end(), model->meshes[i].size(), texture == ParsedModel::NO_TEXTURE ? 0 : firstSlot + texture);
+        }
+
+        firstSlot += static_cast<uint32_t>(model->textures.size());
+    }
+
+    return materials;
+}
+
 std::vector<Vertex> ModelEntityManager::getVertices(const std::string& file) const {
     std::vector<Vertex> vertices{};
 
@@ -116,17 +133,26 @@ size_t ModelEntityManager::getInstanceCount(const std::string& file) const {
 }
 
 size_t ModelEntityManager::getTotalInstanceCount() const {
-    const auto& instances = std::views::transform(groups, &ModelGroup::instances);
-
-    return std::accumulate(instances.begin(), instances.end(), 0, [](uint32_t sum, const auto& instance) {
-        return sum + instance.size();
-    });
+    return groupOffsets.empty() ? 0 : groupOffsets.back();
 }
 
 size_t ModelEntityManager::getTotalModelCount() const {
     return groups.size();
 }
 
+size_t ModelEntityManager::getGlobalIndex(const std::string& file, const size_t index) const {
+    return groupOffsets[indices.at(file)] + index;
+}
+
+void ModelEntityManager::updateGroupOffsets(const size_t group) {
+    groupOffsets.resize(groups.size() + 1);
+    groupOffsets[0] = 0;
+
+    for (size_t i = group; i < groups.size(); ++i) {
+        groupOffsets[i + 1] = groupOffsets[i] + groups[i].instances.size();
+    }
+}
+
 
 uint32_t ModelEntityManager::getIndexCount(const std::string& name) {
     return groups.at(indices[name]).model->indices.size();
@@ -179,9 +205,10 @@ JPH::ShapeRefC ModelEntityManager::staticShape(const std::string& file) {
 }
 
 
-void ModelEntityManager::addBody(const JPH::BodyID id, const std::string& file, size_t index) {
+void ModelEntityManager::addBody(const PhysicsHandle handle, const std::string& file, size_t index) {
     std::lock_guard<std::mutex> lock(bodyID_mutex);
-    bodyID[id] = {file, index};
+    if (handle.world >= bodyID.size()) bodyID.resize(handle.world + 1);
+    bodyID[handle.world][handle.id] = {file, index};
 }
 
 
@@ -197,6 +224,7 @@ void ModelEntityManager::randomVolume(const std::string& file, size_t count, con
 
     auto& group = groups[index];
     group.instances.resize(count);
+    updateGroupOffsets(index);
 
     JPH::BodyCreationSettings settings(physShape(file), JPH::RVec3(0, 0, 0), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Layers::MOVING);
     settings.mOverrideMassProperties = JPH::EOverrideMassProperties::CalculateInertia;
@@ -208,14 +236,18 @@ void ModelEntityManager::randomVolume(const std::string& file, size_t count, con
     for (int x = 0; x < count; ++x) {
         const glm::vec4 pos(Random::randomNum_T(min.x, max.x), Random::randomNum_T(min.y, max.y), Random::randomNum_T(min.z, max.z), 0);
         group.instances[x] = ModelInstance(group.model, pos);
-        settings.mPosition.Set(pos.x, pos.y, pos.z);
-        addBody(physicsBus.createBody(settings), file, x);
+
+        // Own copy, the position decides which world the body lands in
+        JPH::BodyCreationSettings body = settings;
+        body.mPosition.Set(pos.x, pos.y, pos.z);
+        addBody(physicsBus.createBody(body), file, x);
     }
 }
 
 void ModelEntityManager::square(const std::string& file, size_t count, const double gap) {
     auto& group = groups[indices[file]];
     group.instances.resize(count * count);
+    updateGroupOffsets(indices[file]);
 
     JPH::BodyCreationSettings settings(physShape(file), JPH::RVec3(0, 0, 0), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Layers::MOVING);
     settings.mOverrideMassProperties = JPH::EOverrideMassProperties::CalculateInertia;
@@ -229,8 +261,10 @@ void ModelEntityManager::square(const std::string& file, size_t count, const dou
             const glm::vec4 pos(x * gap, y * gap, 0, 0);
 
             group.instances[x * count + y] = ModelInstance(group.model, pos);
-            settings.mPosition.Set(pos.x, pos.y, pos.z);
-            addBody(physicsBus.createBody(settings), file, x * count + y);
+
+            JPH::BodyCreationSettings body = settings;
+            body.mPosition.Set(pos.x, pos.y, pos.z);
+            addBody(physicsBus.createBody(body), file, x * count + y);
         }
     }
 }
@@ -14,6 +14,7 @@
 #include "ParsedModel.hpp"
 #include "ModelGroup.hpp"
 #include "ModelRegion.h"
+#include "DirtyRanges.hpp"
 #include "Random.hpp"
 
 struct ModelEntityManager {
@@ -21,15 +22,19 @@ struct ModelEntityManager {
 
     std::vector<std::string> indexedFiles{};
     std::vector<ModelGroup> groups{};
+    std::vector<size_t> groupOffsets{}; // First global instance index of every group, last entry is the total
 
     std::unordered_map<std::string, size_t> indices{};
-    std::unordered_map<JPH::BodyID, std::pair<std::string, size_t>> bodyID{};
+    std::vector<std::unordered_map<JPH::BodyID, std::pair<std::string, size_t>>> bodyID{}; // Per physics world
 
     std::vector<ModelRegion> regions{};
     std::vector<std::vector<size_t>> modelRegions{};
 
     std::mutex bodyID_mutex;
-    std::array<bool, 4> dirty{true, true, true, true};
+    std::array<bool, 4> dirty{true, true, true, true}; // Full rebuilds: model data, matrix mirror, culling, unused
+    DirtyRanges changedInstances{}; // Global instance indices whose model and culling data have to be uploaded
+
+    bool collisionOnly = false; // Load geometry without textures (headless)
 
     PhysicsBus physicsBus{};
     Logger LOGGER{"ModelEntityManager"};
@@ -54,6 +59,9 @@ struct ModelEntityManager {
     std::vector<Vertex> getAllVertices() const;
 
     std::vector<Vertex> getVertices(const std::string& file) const;
+
+    // Texture descriptor slot of every vertex in vertex buffer order, slot 0 is the missing texture
+    std::vector<uint32_t> getAllMaterials() const;
     #pragma endregion
 
     #pragma region count
@@ -65,6 +73,12 @@ struct ModelEntityManager {
 
     size_t getTotalModelCount() const;
 
+    // Index of instance in the flat per-instance gpu buffers
+    size_t getGlobalIndex(const std::string& file, size_t index) const;
+
+    // Rebuilds groupOffsets from group on, call after a group gains or loses instances
+    void updateGroupOffsets(size_t group = 0);
+
 
 
     uint32_t getIndexCount(const std::string& name);
@@ -81,7 +95,7 @@ struct ModelEntityManager {
 
     JPH::ShapeRefC staticShape(const std::string& file);
 
-    void addBody(JPH::BodyID id, const std::string& file, size_t index);
+    void addBody(PhysicsHandle handle, const std::string& file, size_t index);
 
     void randomVolume(const std::string& file, size_t count, float mass, const glm::vec3& min, const glm::vec3& max);
 
@@ -93,13 +107,18 @@ struct ModelEntityManager {
 
         if (indices.contains(file)) {
             groups[indices[file]].instances.emplace_back(groups[indices[file]].model, args...);
-            dirty.fill(true);
+            updateGroupOffsets(indices[file]);
+
+            // Appending to a group shifts every later group, so everything from the new instance on moves
+            changedInstances.add(getGlobalIndex(file, groups[indices[file]].instances.size() - 1), getTotalInstanceCount());
+            dirty[1] = true;
 
-            const auto id = physicsBus.createBody(settings);
-            addBody(id, file, groups[indices[file]].instances.size() - 1);
+            // Velocity goes in with the settings, the body can't be touched once the tick thread steps again
+            JPH::BodyCreationSettings moving = settings;
+            moving.mLinearVelocity = JPH::Vec3(impulse.x, impulse.y, impulse.z);
 
-            JPH::BodyInterface &body_interface = physicsBus.physics_system->GetBodyInterface();
-            body_interface.SetLinearVelocity(id, JPH::Vec3(impulse.x, impulse.y, impulse.z));
+            const PhysicsHandle handle = physicsBus.createBody(moving);
+            addBody(handle, file, groups[indices[file]].instances.size() - 1);
         } else {
             LOGGER.error("File ${} does not exist", file);
         }
@@ -117,9 +136,11 @@ struct ModelEntityManager {
             modelRegions.emplace_back(index);
 
             indices.insert({file, index++});
-            groups.emplace_back(std::make_shared<ParsedModel>(std::string{PROJECT_ROOT} + location + file));
+            groups.emplace_back(std::make_shared<ParsedModel>(std::string{PROJECT_ROOT} + location + file, collisionOnly));
         }
         index = 0;
+
+        updateGroupOffsets();
     }
 
     void staticInstance(const std::string& file, glm::vec4 pos);
@@ -10,14 +10,12 @@
 void SwapchainManager::cleanupOffscreenImages() const {
     for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
         vkDestroyImageView(device, offscreenImageViews[i], nullptr);
-        vkDestroyImage(device, offscreenImages[i], nullptr);
-        vkFreeMemory(device, offscreenImagesMemory[i], nullptr);
+        Images::destroyImage(device, offscreenImages[i], offscreenImagesMemory[i]);
     }
 }
 
 void SwapchainManager::cleanupSwapchain() const {
-    vkDestroyImage(device, depthImage, nullptr);
-    vkFreeMemory(device, depthImageMemory, nullptr);
+    Images::destroyImage(device, depthImage, depthImageMemory);
     vkDestroyImageView(device, depthImageView, nullptr);
 
     for (auto& swapchainImageView : swapchainImageViews) {
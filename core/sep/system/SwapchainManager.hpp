@@ -8,6 +8,7 @@
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
+#include "GpuAllocator.hpp"
 #include "Swapchain.hpp"
 
 struct SwapchainManager {
@@ -30,12 +31,12 @@ struct SwapchainManager {
 
     // Postprocess
     std::vector<VkImage> offscreenImages{};
-    std::vector<VkDeviceMemory> offscreenImagesMemory{};
+    std::vector<GpuAllocation> offscreenImagesMemory{};
     std::vector<VkImageView> offscreenImageViews{};
 
     // Depth
     VkImage depthImage{};
-    VkDeviceMemory depthImageMemory{};
+    GpuAllocation depthImageMemory{};
     VkImageView depthImageView{};
 
     #pragma region Dependencies
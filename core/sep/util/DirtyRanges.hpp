@@ -0,0 +1,79 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+#ifndef INC_2G43S_DIRTYRANGES_H
+#define INC_2G43S_DIRTYRANGES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Element ranges [begin, end) waiting for an upload, merged into a handful of copy regions before they are used
+struct DirtyRanges {
+    struct Range {
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    std::vector<Range> ranges{};
+
+    void add(const size_t begin, const size_t end) {
+        if (begin >= end) return;
+
+        // Streaming mostly touches neighbours of the last write
+        if (!ranges.empty() && ranges.back().end == begin) {
+            ranges.back().end = end;
+            return;
+        }
+
+        ranges.emplace_back(begin, end);
+    }
+
+    void add(const size_t index) {
+        add(index, index + 1);
+    }
+
+    void add(const DirtyRanges& other) {
+        for (const Range& range : other.ranges) add(range.begin, range.end);
+    }
+
+    // Sorts and merges ranges closer than maxGap elements, the gap grows until at most maxRanges are left.
+    // Gaps are uploaded too, so only use a gap when the source data is valid between the ranges, 0 only merges touching ones
+    void coalesce(size_t maxGap, const size_t maxRanges) {
+        if (ranges.empty()) return;
+
+        std::ranges::sort(ranges, {}, &Range::begin);
+
+        while (true) {
+            size_t last = 0;
+            for (size_t i = 1; i < ranges.size(); ++i) {
+                if (ranges[i].begin <= ranges[last].end + maxGap) {
+                    ranges[last].end = std::max(ranges[last].end, ranges[i].end);
+                } else {
+                    ranges[++last] = ranges[i];
+                }
+            }
+            ranges.resize(last + 1);
+
+            if (ranges.size() <= maxRanges || maxGap == 0) return;
+            maxGap *= 2;
+        }
+    }
+
+    // Drops everything at or past limit
+    void clamp(const size_t limit) {
+        std::erase_if(ranges, [&](const Range& range) { return range.begin >= limit; });
+        for (Range& range : ranges) range.end = std::min(range.end, limit);
+    }
+
+    [[nodiscard]] bool empty() const {
+        return ranges.empty();
+    }
+
+    void clear() {
+        ranges.clear();
+    }
+};
+
+#endif //INC_2G43S_DIRTYRANGES_H
@@ -8,6 +8,7 @@
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    std::optional<uint32_t> transferFamily; // Only set for a family without graphics, uploads use the graphics one otherwise
 
     bool isComplete() {
         return graphicsFamily.has_value() && presentFamily.has_value();
@@ -29,7 +30,7 @@ struct Queue {
         int i = 0;
         for (const auto& queueFamily : queueFamilies) {
             // Comparing bits and then setting firstIndex of graphicsFamily
-            if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+            if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT && !indices.graphicsFamily.has_value()) {
                 indices.graphicsFamily = i;
             }
 
@@ -38,14 +39,18 @@ struct Queue {
             vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
 
             // Setting firstIndex
-            if (presentSupport) {
+            if (presentSupport && !indices.presentFamily.has_value()) {
                 indices.presentFamily = i;
             }
 
-            // If graphics and present family != null break for loop
-            if (indices.isComplete()) {
-                break;
+            // Transfer only family is the copy engine, one that can compute as well is the next best thing
+            if (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+                const bool transferOnly = !(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT);
+                if (!indices.transferFamily.has_value() || transferOnly) {
+                    indices.transferFamily = i;
+                }
             }
+
             i++;
         }
 
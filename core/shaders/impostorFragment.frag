@@ -0,0 +1,18 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : enable
+
+layout(binding = 0) uniform sampler2D texSampler[];
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) in flat uint textureIndex;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec4 color = texture(texSampler[nonuniformEXT(textureIndex)], fragTexCoord);
+
+    // Atlas texels nothing was baked into
+    if (color.a < 0.5) discard;
+
+    outColor = color;
+}
@@ -0,0 +1,75 @@
+#version 460
+
+#extension GL_EXT_buffer_reference2 : require
+#extension GL_EXT_scalar_block_layout : enable
+
+struct CullingObject {
+    vec4 sphere; // World space
+    uint drawCommand; // Atlas row
+    uint pad[3];
+};
+
+layout(scalar, buffer_reference) readonly buffer UniformBufferObject {
+    mat4 view;
+    mat4 projection;
+    uint modelCount;
+};
+
+layout(scalar, buffer_reference) readonly buffer ModelBuffer {
+    mat4 models[];
+};
+
+layout(scalar, buffer_reference) readonly buffer CullingBuffer {
+    CullingObject objects[];
+};
+
+layout(scalar, buffer_reference) readonly buffer Impostors {
+    uint vertexCount;
+    uint instanceCount;
+    uint firstVertex;
+    uint firstInstance;
+    uint indices[];
+};
+
+layout(push_constant) uniform Push {
+    UniformBufferObject uniformBufferObject;
+    ModelBuffer modelBuffer;
+    CullingBuffer cullingBuffer;
+    Impostors impostors;
+    uint atlasSlot;
+    uint views;
+    uint rows;
+} constants;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out flat uint textureIndex;
+
+const vec2 corners[6] = vec2[](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0)
+);
+
+const float TWO_PI = 6.28318530718;
+
+void main() {
+    uint instance = constants.impostors.indices[gl_InstanceIndex];
+    CullingObject object = constants.cullingBuffer.objects[instance];
+    mat4 view = constants.uniformBufferObject.view;
+
+    // Camera facing quad over the bounding sphere, right and up are the rows of the view rotation
+    vec2 corner = corners[gl_VertexIndex];
+    vec3 right = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
+    vec3 position = object.sphere.xyz + (right * corner.x + up * corner.y) * object.sphere.w;
+
+    gl_Position = constants.uniformBufferObject.projection * view * vec4(position, 1.0);
+
+    // Baked view closest to the camera's azimuth in model space
+    vec3 eye = -transpose(mat3(view)) * view[3].xyz;
+    vec3 local = transpose(mat3(constants.modelBuffer.models[instance])) * (eye - object.sphere.xyz);
+    uint column = uint(round(atan(local.y, local.x) / TWO_PI * float(constants.views)) + float(constants.views)) % constants.views;
+
+    vec2 tile = corner * vec2(0.5, -0.5) + 0.5;
+    fragTexCoord = (vec2(column, object.drawCommand) + tile) / vec2(constants.views, constants.rows);
+    textureIndex = constants.atlasSlot;
+}
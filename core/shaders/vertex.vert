@@ -11,17 +11,6 @@ struct VisibleIndicesBufferObject {
     uint index;
 };
 
-struct TextureIndexBufferObject {
-    uint firstIndex;
-    uint indexCount;
-    uint globalVertexOffset;
-    uint pad2;
-};
-
-struct TextureIndexOffsetBufferObject {
-    uint indexOffset;
-};
-
 layout(scalar, buffer_reference) readonly buffer UniformBufferObject {
     mat4 view; // Camera view
     mat4 projection; // Camera projection
@@ -36,21 +25,16 @@ layout(scalar, buffer_reference) readonly buffer VisibleIndicesBuffer {
     VisibleIndicesBufferObject objects[];
 };
 
-
-layout(scalar, buffer_reference) readonly buffer TextureIndexBuffer {
-    TextureIndexBufferObject objects[];
-};
-
-layout(scalar, buffer_reference) readonly buffer TextureIndexOffsetBuffer {
-    TextureIndexOffsetBufferObject objects[];
+// Texture slot of every vertex, resolved per primitive when the model is loaded
+layout(scalar, buffer_reference) readonly buffer MaterialBuffer {
+    uint slots[];
 };
 
 layout(push_constant) uniform Push {
     UniformBufferObject uniformBufferObject;
     ModelBuffer modelBuffer;
     VisibleIndicesBuffer visibleIndicesBuffer;
-    TextureIndexBuffer textureIndexBuffer;
-    TextureIndexOffsetBuffer textureIndexOffsetBuffer;
+    MaterialBuffer materialBuffer;
 } constants;
 
 
@@ -64,32 +48,15 @@ layout(location = 1) out vec2 fragTexCoord;
 layout(location = 2) out flat uint textureIndex;
 
 void main() {
-    uint modelIndex = gl_DrawID;
     uint instanceIndex = gl_InstanceIndex;
 
     uint visibleInstanceIndex = constants.visibleIndicesBuffer.objects[instanceIndex].index;
     gl_Position = constants.uniformBufferObject.projection * constants.uniformBufferObject.view * constants.modelBuffer.objects[visibleInstanceIndex].model * vec4(inPosition, 1.0);
 
 
-    // Texture indexing stuff
     fragColor = inColor;
     fragTexCoord = inTexCoord;
 
-    uint firstIndex = constants.textureIndexBuffer.objects[modelIndex].firstIndex;
-    uint rawIndex = 0;
-    uint models = constants.uniformBufferObject.modelCount;
-
-    uint textures = constants.textureIndexBuffer.objects[modelIndex].indexCount;
-
-    for(uint i = 0; i < textures; i++) {
-        if (gl_VertexIndex > constants.textureIndexBuffer.objects[modelIndex].globalVertexOffset + constants.textureIndexOffsetBuffer.objects[firstIndex + i].indexOffset) {
-            rawIndex++;
-        }
-    }
-
-    // This probably gonna get me brutally mauled one day
-    if (rawIndex == 0) rawIndex = 1;
-
-    //textureIndex = firstIndex + rawIndex;
-    textureIndex = firstIndex + rawIndex;
+    // gl_VertexIndex already has the model's vertexOffset in it
+    textureIndex = constants.materialBuffer.slots[gl_VertexIndex];
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
 #include <SDL3/SDL_main.h>
 #include <SDL3/SDL.h>
 
+#include <charconv>
 #include <cmath>
+#include <cstring>
+#include <string>
 #include <thread>
 
 #define GLM_FORCE_RADIANS
@@ -26,20 +29,31 @@ struct AppContext {
     MouseListener* mL;
 
     SDL_Thread* tickThread = nullptr;
+
+    // --headless runs scene and physics only, --ticks N quits after N physics ticks (0 runs forever)
+    bool headless = false;
+    uint64_t maxTicks = 0;
+
     double desiredFrameRate = 200;
     uint64_t sleepTimeTotalNS = 1 / desiredFrameRate * 1'000'000'000.0;
 };
 
 int TickThread(void* ptr) {
-    constexpr uint TICK_RATE = 256;
-
     auto* app = static_cast<AppContext*>(ptr);
-    constexpr double dt = 1.0 / TICK_RATE;
+    const double dt = app->engine->modelEntityManager.physicsBus.cDeltaTime;
 
+    uint64_t last = SDL_GetTicksNS();
+    uint64_t ticks = 0;
     while (!app->engine->quit) {
         const uint64_t start = SDL_GetTicksNS();
+        const double wall = static_cast<double>(start - last) / 1'000'000'000.0; // Real time since last tick, the stepper catches up or drops from it
+        last = start;
 
-        //if (app->engine->initialized) app->engine->modelEntityManager.physicsBus.iterateJPH(*app->engine);
+        if (app->headless) {
+            ticks += app->engine->modelEntityManager.physicsBus.advance(wall);
+            if (app->maxTicks && ticks >= app->maxTicks) app->engine->quit = true;
+        }
+        else if (app->engine->initialized) app->engine->modelEntityManager.physicsBus.iterateJPH(wall);
 
         const uint64_t elapsed = SDL_GetTicksNS() - start;
         double sleepTime = dt - static_cast<double>(elapsed) / 1'000'000'000.0;
@@ -60,6 +74,56 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
         setenv("OMP_PLACES", "cores", 1);
     #endif
 
+    bool headless = false;
+    uint64_t maxTicks = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--headless")) headless = true;
+        else if (!std::strcmp(argv[i], "--ticks")) {
+            const char* value = i + 1 < argc ? argv[++i] : "";
+            const char* end = value + std::strlen(value);
+            if (const auto [ptr, ec] = std::from_chars(value, end, maxTicks); ec != std::errc{} || ptr != end) {
+                LOGGER.error("Usage: ${} [--headless] [--ticks N]", argv[0]);
+                return SDL_APP_FAILURE;
+            }
+        }
+    }
+
+    if (headless) {
+        // Events only, so ctrl+c still arrives as SDL_EVENT_QUIT
+        if (!SDL_Init(SDL_INIT_EVENTS)) {
+            return SDL_Fail();
+        }
+
+        Engine* engine = new Engine();
+
+        *appstate = new AppContext{
+            engine,
+            new KeyListener{},
+            new MouseListener{},
+        };
+
+        auto* app = static_cast<AppContext*>(*appstate);
+        app->headless = true;
+        app->maxTicks = maxTicks;
+
+        engine->desiredFrameRate = &app->desiredFrameRate;
+        engine->sleepTimeTotalNS = &app->sleepTimeTotalNS;
+        engine->modelEntityManager.physicsBus.initializeJPH();
+        engine->initializeHeadless();
+
+        app->tickThread = SDL_CreateThread(TickThread, "TickThread", app);
+
+        if (!app->tickThread) {
+            LOGGER.error("Failed to INITIALIZE tick thread!");
+            return SDL_APP_FAILURE;
+        }
+
+        LOGGER.info("Session ID: ${}", engine->sid);
+        LOGGER.success("Application STARTED headless!");
+
+        return SDL_APP_CONTINUE;
+    }
+
     basist::basisu_transcoder_init();
 
     // Init the library, here we make a window so we only need the Video capabilities.
@@ -133,6 +197,8 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *e) {
         return SDL_APP_SUCCESS;
     }
 
+    if (app->headless) return SDL_APP_CONTINUE;
+
     if (e->type == SDL_EVENT_WINDOW_RESIZED) {
         int width, height;
         SDL_GetWindowSizeInPixels(app->engine->window, &width, &height);
@@ -176,9 +242,20 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
     const auto* app = static_cast<AppContext *>(appstate);
     const uint64_t& sleepTime = app->sleepTimeTotalNS;
 
+    // Tick thread does all the work, just wait for it to finish
+    if (app->headless) {
+        if (app->engine->quit) return SDL_APP_SUCCESS;
+
+        SDL_DelayNS(sleepTime);
+        return SDL_APP_CONTINUE;
+    }
+
     app->engine->delta.calculateDelta();
     app->kL->iterateKeys(*app->engine);
 
+    // Poses published by the tick thread since the last frame
+    app->engine->modelEntityManager.physicsBus.syncJPH(*app->engine);
+
     app->engine->graphicsManager.drawFrame();
 
     renderDurationNs = SDL_GetTicksNS() - start;
@@ -200,9 +277,13 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
 void SDL_AppQuit(void *appstate, SDL_AppResult result) {
     // Cleanup
     if (const auto* app = static_cast<AppContext *>(appstate)) {
+        // Tick thread must be done stepping before the physics goes away
+        app->engine->quit = true;
+        if (app->tickThread) SDL_WaitThread(app->tickThread, nullptr);
+
         app->engine->modelEntityManager.physicsBus.shutdownJPH();
         app->engine->cleanup();
-        SDL_DestroyWindow(app->engine->window);
+        if (!app->headless) SDL_DestroyWindow(app->engine->window);
         delete app;
     }
 
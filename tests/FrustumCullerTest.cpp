@@ -0,0 +1,104 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+// FrustumCuller against hand-built spheres and planes. Ten objects, so the SSE path takes the first eight and the
+// scalar path the rest
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "FrustumCuller.hpp"
+
+static bool check(const bool condition, const char* what) {
+    if (!condition) std::fprintf(stderr, "FAILED: %s\n", what);
+    return condition;
+}
+
+// Indices a command drew, sorted since the culler only promises them as a set
+static std::vector<uint32_t> drawn(const std::vector<VkDrawIndexedIndirectCommand>& commands, const std::vector<uint32_t>& visibleIndices, const uint32_t command) {
+    const auto begin = visibleIndices.begin() + commands[command].firstInstance;
+    std::vector<uint32_t> indices(begin, begin + commands[command].instanceCount);
+    std::ranges::sort(indices);
+    return indices;
+}
+
+int main() {
+    // Camera at the origin looking down -z, view depth is -z. The frustum is the box x, y in [-10, 10], z in [-1000, -1]
+    UniformCullingBuffer culling{};
+    culling.planes[0] = glm::vec4(1.0f, 0.0f, 0.0f, 10.0f);
+    culling.planes[1] = glm::vec4(-1.0f, 0.0f, 0.0f, 10.0f);
+    culling.planes[2] = glm::vec4(0.0f, 1.0f, 0.0f, 10.0f);
+    culling.planes[3] = glm::vec4(0.0f, -1.0f, 0.0f, 10.0f);
+    culling.planes[4] = glm::vec4(0.0f, 0.0f, -1.0f, -1.0f);
+    culling.planes[5] = glm::vec4(0.0f, 0.0f, 1.0f, 1000.0f);
+    culling.viewProjection = glm::mat4(1.0f);
+    culling.viewProjection[2][3] = -1.0f;
+    culling.viewProjection[3][3] = 0.0f;
+
+    culling.pixelScale = 1000.0f; // Radius 1 at depth 1000 is one pixel
+    culling.minPixelRadius = 1.0f;
+    culling.impostorDistance = 100.0f;
+    culling.impostorRows = 1; // Only command 0 has an impostor
+
+    const std::vector<CullingData> objects{
+        {glm::vec4(0.0f, 0.0f, -20.0f, 1.0f), 0},   // 0 inside
+        {glm::vec4(50.0f, 0.0f, -20.0f, 1.0f), 0},  // 1 outside
+        {glm::vec4(10.5f, 0.0f, -20.0f, 1.0f), 0},  // 2 straddling the right plane
+        {glm::vec4(0.0f, 0.0f, -50.0f, 0.01f), 0},  // 3 too small
+        {glm::vec4(0.0f, 0.0f, -200.0f, 2.0f), 0},  // 4 impostor band
+        {glm::vec4(0.0f, 0.0f, -200.0f, 2.0f), 1},  // 5 impostor band without an atlas row, stays a mesh
+        {glm::vec4(0.0f, 0.0f, -0.5f, 1.0f), 1},    // 6 around the camera
+        {glm::vec4(11.5f, 0.0f, -20.0f, 1.0f), 1},  // 7 just past the right plane
+        {glm::vec4(0.0f, 5.0f, -30.0f, 1.0f), 1},   // 8 inside, scalar path
+        {glm::vec4(0.0f, 0.0f, -2000.0f, 1.0f), 1}, // 9 past the far plane, scalar path
+    };
+
+    const std::vector<VkDrawIndexedIndirectCommand> source{
+        {36, 0, 0, 0, 0},
+        {36, 0, 0, 0, 5},
+    };
+
+    bool passed = true;
+
+    passed &= check(FrustumCuller::isSphereInFrustum(objects[0].sphere, culling.planes), "inside sphere in frustum");
+    passed &= check(!FrustumCuller::isSphereInFrustum(objects[1].sphere, culling.planes), "outside sphere culled");
+    passed &= check(FrustumCuller::isSphereInFrustum(objects[2].sphere, culling.planes), "straddling sphere in frustum");
+    passed &= check(!FrustumCuller::isSphereInFrustum(objects[7].sphere, culling.planes), "sphere past a plane culled");
+
+    const ShaderSpecialization specialization{};
+    passed &= check(FrustumCuller::band(objects[0].sphere, 0, culling, specialization) == FrustumCuller::Band::MESH, "near sphere is a mesh");
+    passed &= check(FrustumCuller::band(objects[3].sphere, 0, culling, specialization) == FrustumCuller::Band::DROPPED, "small sphere dropped");
+    passed &= check(FrustumCuller::band(objects[4].sphere, 0, culling, specialization) == FrustumCuller::Band::IMPOSTOR, "far sphere is an impostor");
+    passed &= check(FrustumCuller::band(objects[5].sphere, 1, culling, specialization) == FrustumCuller::Band::MESH, "far sphere without a row is a mesh");
+    passed &= check(FrustumCuller::band(objects[6].sphere, 1, culling, specialization) == FrustumCuller::Band::MESH, "sphere around the camera is a mesh");
+
+    std::vector<VkDrawIndexedIndirectCommand> commands = source;
+    std::vector<uint32_t> visibleIndices{};
+    std::vector<uint32_t> impostorIndices{};
+
+    FrustumCuller::cull(objects, objects.size(), culling, specialization, commands, visibleIndices, impostorIndices);
+    passed &= check(drawn(commands, visibleIndices, 0) == std::vector<uint32_t>{0, 2}, "command 0 draws the inside and straddling spheres");
+    passed &= check(drawn(commands, visibleIndices, 1) == std::vector<uint32_t>{5, 6, 8}, "command 1 draws the far, around and scalar spheres");
+    passed &= check(impostorIndices == std::vector<uint32_t>{4}, "one impostor");
+
+    // Meshes only, the impostor band falls back to meshes
+    ShaderSpecialization meshesOnly{};
+    meshesOnly.lodCount = 1;
+    commands = source;
+    FrustumCuller::cull(objects, objects.size(), culling, meshesOnly, commands, visibleIndices, impostorIndices);
+    passed &= check(drawn(commands, visibleIndices, 0) == std::vector<uint32_t>{0, 2, 4}, "lod count 1 draws the impostor as a mesh");
+    passed &= check(impostorIndices.empty(), "lod count 1 has no impostors");
+
+    // Culling off draws everything as a mesh
+    ShaderSpecialization unculled{};
+    unculled.culling = 0;
+    commands = source;
+    FrustumCuller::cull(objects, objects.size(), culling, unculled, commands, visibleIndices, impostorIndices);
+    passed &= check(drawn(commands, visibleIndices, 0) == std::vector<uint32_t>{0, 1, 2, 3, 4}, "culling off draws all of command 0");
+    passed &= check(drawn(commands, visibleIndices, 1) == std::vector<uint32_t>{5, 6, 7, 8, 9}, "culling off draws all of command 1");
+    passed &= check(impostorIndices.empty(), "culling off has no impostors");
+
+    return passed ? 0 : 1;
+}
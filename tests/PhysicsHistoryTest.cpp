@@ -0,0 +1,38 @@
+//
+// Created by down1 on 19.10.2026.
+//
+
+// Rewinding repeatedly must replace the frozen list, not keep appending to it
+
+#include <cstdio>
+
+#include "PhysicsBus.hpp"
+
+static bool check(const bool condition, const char* what) {
+    if (!condition) std::fprintf(stderr, "FAILED: %s\n", what);
+    return condition;
+}
+
+int main() {
+    PhysicsBus bus{};
+    bus.THREADS = 0;
+    bus.initializeJPH();
+
+    // One sleeping box, keyframes store it so every restore reports it as frozen
+    const JPH::BodyCreationSettings settings(new JPH::BoxShape(JPH::Vec3(0.5f, 0.5f, 0.5f)), JPH::RVec3(0, 0, 0), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Layers::MOVING);
+    const PhysicsHandle handle = bus.createBody(settings, 0);
+    bus.world(0).physics_system->GetBodyInterface().DeactivateBody(handle.id);
+
+    for (int i = 0; i < 8; ++i) {
+        bus.advance(bus.cDeltaTime);
+    }
+
+    bool passed = true;
+    passed &= check(bus.rewind(2, false), "first rewind");
+    passed &= check(bus.world(0).frozenBodies.size() == 1, "one frozen body after the first rewind");
+    passed &= check(bus.rewind(2, false), "second rewind");
+    passed &= check(bus.world(0).frozenBodies.size() == 1, "one frozen body after the second rewind");
+
+    bus.shutdownJPH();
+    return passed ? 0 : 1;
+}